@@ -0,0 +1,148 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "circuit_breaker.hpp"
+
+#include "state_file.hpp"
+#include "util.hpp"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <utility>
+
+namespace mastorss
+{
+using std::int64_t;
+using std::min;
+using std::uint32_t;
+using std::chrono::seconds;
+
+CircuitBreaker::CircuitBreaker(fs::path path)
+    : _path{std::move(path)}
+{}
+
+optional<system_clock::time_point> CircuitBreaker::blocked(
+    const string_view host)
+{
+    optional<system_clock::time_point> probe;
+    modify_state_file(
+        _path,
+        [&probe, key = string(host)](Json::Value &json)
+        {
+            if (!json.isMember(key))
+            {
+                return;
+            }
+            Json::Value &entry{json[key]};
+            const auto failures{entry["failures"].asUInt()};
+            if (failures < threshold)
+            {
+                return;
+            }
+
+            const auto next_probe{entry["next_probe"].asInt64()};
+            if (next_probe > unix_now())
+            {
+                probe = system_clock::from_time_t(next_probe);
+                return;
+            }
+            entry["next_probe"] = Json::Int64{unix_now()
+                                              + backoff(failures).count()};
+        });
+
+    return probe;
+}
+
+void CircuitBreaker::succeeded(const string_view host)
+{
+    modify_state_file(_path,
+                      [key = string(host)](Json::Value &json)
+                      { json.removeMember(key); });
+}
+
+void CircuitBreaker::failed(const string_view host)
+{
+    modify_state_file(
+        _path,
+        [key = string(host)](Json::Value &json)
+        {
+            Json::Value &entry{json[key]};
+            const uint32_t failures{entry["failures"].asUInt() + 1};
+            entry["failures"] = failures;
+            if (failures >= threshold)
+            {
+                entry["next_probe"] = Json::Int64{
+                    unix_now() + backoff(failures).count()};
+            }
+        });
+}
+
+string CircuitBreaker::host_of(const string_view url)
+{
+    size_t start{url.find("://")};
+    start = (start == string_view::npos) ? 0 : start + 3;
+    string_view host{url.substr(start, url.find_first_of("/?#", start)
+                                           - start)};
+    const size_t pos_at{host.rfind('@')};
+    if (pos_at != string_view::npos)
+    {
+        host.remove_prefix(pos_at + 1);
+    }
+
+    string lower(host);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](const unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    return lower;
+}
+
+bool CircuitBreaker::host_failure(const HTTPException &e)
+{
+    return e.error_code == 429 || e.error_code >= 500;
+}
+
+bool CircuitBreaker::host_failure(const curl_wrapper::CURLException &e)
+{
+    if (e.deadline_reached)
+    {
+        return false;
+    }
+
+    switch (e.error_code)
+    {
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+seconds CircuitBreaker::backoff(const uint32_t failures)
+{
+    // Stop doubling long before it could overflow.
+    const uint32_t doublings{min(failures - threshold, uint32_t{16})};
+    return min(backoff_base * (int64_t{1} << doublings), backoff_max);
+}
+} // namespace mastorss
@@ -0,0 +1,123 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_CIRCUIT_BREAKER_HPP
+#define MASTORSS_CIRCUIT_BREAKER_HPP
+
+#include "curl_wrapper.hpp"
+#include "exceptions.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mastorss
+{
+namespace fs = boost::filesystem;
+using std::optional;
+using std::string;
+using std::string_view;
+using std::chrono::system_clock;
+
+/*!
+ *  @brief  Remembers feed hosts that fail and tells when to try them again.
+ *
+ *  After #threshold failures in a row, a host is skipped until its next probe
+ *  is due. Only errors that concern the whole host count, see host_failure().
+ *  The time between probes doubles with every failure, from #backoff_base up
+ *  to #backoff_max. One success forgets all failures.
+ *
+ *  The failures are kept in a small file that is locked while it is used, so
+ *  that all processes and profiles share it. Problems with the file are
+ *  logged and never stop a download.
+ *
+ *  @since  0.14.0
+ */
+class CircuitBreaker
+{
+public:
+    //! Failures in a row after which a host is skipped. @since  0.14.0
+    static constexpr std::uint32_t threshold{2};
+    //! Time between the first probes. @since  0.14.0
+    static constexpr std::chrono::seconds backoff_base{15 * 60};
+    //! Maximum time between probes. @since  0.14.0
+    static constexpr std::chrono::seconds backoff_max{24 * 60 * 60};
+
+    //! Construct a breaker that allows everything. @since  0.14.0
+    CircuitBreaker() = default;
+
+    //! Use the failures in `path`, it is created when needed. @since  0.14.0
+    explicit CircuitBreaker(fs::path path);
+
+    /*!
+     *  @brief  Check if a request to `host` may be made now.
+     *
+     *  If the next probe of a failing host is due, the request is allowed and
+     *  the probe after it is scheduled, so that other processes keep skipping
+     *  the host while it is probed.
+     *
+     *  @return Empty if the request may be made, otherwise the time of the
+     *          next probe.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] optional<system_clock::time_point> blocked(string_view host);
+
+    //! Forget the failures of `host`. @since  0.14.0
+    void succeeded(string_view host);
+
+    //! Count a failure of `host`. @since  0.14.0
+    void failed(string_view host);
+
+    /*!
+     *  @brief  Returns the lowercase host and port of `url`.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] static string host_of(string_view url);
+
+    /*!
+     *  @brief  Returns `true` if the error concerns the whole host.
+     *
+     *  Server errors and 429 do, errors of one feed like 404 don't.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] static bool host_failure(const HTTPException &e);
+
+    /*!
+     *  @brief  Returns `true` if the error concerns the whole host.
+     *
+     *  Connection errors and timeouts do, unless the deadline of the run was
+     *  reached.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] static bool
+    host_failure(const curl_wrapper::CURLException &e);
+
+private:
+    fs::path _path;
+
+    [[nodiscard]] static std::chrono::seconds backoff(std::uint32_t failures);
+};
+} // namespace mastorss
+
+#endif // MASTORSS_CIRCUIT_BREAKER_HPP
@@ -0,0 +1,76 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compiled_profile.hpp"
+
+#include "config.hpp"
+
+#include <list>
+#include <utility>
+#include <vector>
+
+namespace mastorss
+{
+using std::list;
+using std::pair;
+using std::vector;
+
+CompiledProfile::CompiledProfile(const ProfileData &data)
+{
+    list<pair<string, string>> fixes;
+    for (const auto &fix : data.fixes)
+    {
+        fixes.emplace_back(fix, "");
+    }
+    _fixes = ReplacementEngine{fixes, "fixes"};
+    _replacements = ReplacementEngine{data.replacements, "replacements"};
+
+    const vector<string_view> skip(data.skip.begin(), data.skip.end());
+    _skip = PrefixTrie{skip};
+
+    _post_template = PostTemplate{data.post_template.empty()
+                                      ? default_template(data)
+                                      : data.post_template};
+}
+
+string CompiledProfile::default_template(const ProfileData &data)
+{
+    string text;
+    if (!data.titles_as_cw)
+    {
+        text = "{title}";
+    }
+    if (!data.titles_only)
+    {
+        if (!text.empty())
+        {
+            text += "\n\n";
+        }
+        text += "{description}";
+    }
+    if (!text.empty())
+    {
+        text += "\n\n";
+    }
+    text += "{link}";
+    if (!data.append.empty())
+    {
+        text += "\n\n{append}";
+    }
+
+    return text;
+}
+} // namespace mastorss
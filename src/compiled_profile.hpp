@@ -0,0 +1,101 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_COMPILED_PROFILE_HPP
+#define MASTORSS_COMPILED_PROFILE_HPP
+
+#include "post_template.hpp"
+#include "prefix_trie.hpp"
+#include "replacement_engine.hpp"
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace mastorss
+{
+using std::string;
+using std::string_view;
+
+struct ProfileData;
+
+/*!
+ *  @brief  The patterns of a profile, compiled once.
+ *
+ *  Built when the configuration is loaded and used for every item.
+ *
+ *  @since  0.14.0
+ */
+class CompiledProfile
+{
+public:
+    //! Construct without patterns. @since  0.14.0
+    CompiledProfile() = default;
+
+    /*!
+     *  @brief  Compile the `fixes`, `replacements`, `skip` and `template` of
+     *          the profile.
+     *
+     *  Throws ConfigException if a pattern is invalid.
+     *
+     *  @since  0.14.0
+     */
+    explicit CompiledProfile(const ProfileData &data);
+
+    //! Delete everything that matches one of the fixes. @since  0.14.0
+    [[nodiscard]] inline string apply_fixes(string text) const
+    {
+        return _fixes.apply(std::move(text));
+    }
+
+    //! Apply the replacements, in order. @since  0.14.0
+    [[nodiscard]] inline string apply_replacements(string text) const
+    {
+        return _replacements.apply(std::move(text));
+    }
+
+    /*!
+     *  @brief  Returns `true` if the title starts with one of the skip
+     *          prefixes.
+     *
+     *  Does not allocate and looks at every character of the title at most
+     *  once.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] inline bool skip(const string_view title) const
+    {
+        return _skip.match(title).has_value();
+    }
+
+    //! The layout of the status. @since  0.14.0
+    [[nodiscard]] inline const PostTemplate &post_template() const
+    {
+        return _post_template;
+    }
+
+private:
+    ReplacementEngine _fixes;
+    ReplacementEngine _replacements;
+    PrefixTrie _skip;
+    PostTemplate _post_template;
+
+    //! The layout that was hard-coded before templates were introduced.
+    [[nodiscard]] static string default_template(const ProfileData &data);
+};
+} // namespace mastorss
+
+#endif // MASTORSS_COMPILED_PROFILE_HPP
@@ -17,11 +17,13 @@
 #include "config.hpp"
 
 #include "exceptions.hpp"
+#include "state_file.hpp"
 
 #include <boost/log/trivial.hpp>
 #include <mastodonpp/mastodonpp.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -43,6 +45,13 @@ using std::stoul;
 using std::stringstream;
 using std::transform;
 
+namespace
+{
+//! Keys that moved from the config file to state files.
+constexpr std::array<const char *, 5> state_keys{
+    "guids", "etag", "last_modified", "arrivals", "next_check"};
+} // namespace
+
 std::ostream &operator<<(std::ostream &out, const ProfileData &data)
 {
     out << "append: \"" << data.append << "\", "
@@ -57,19 +66,21 @@ std::ostream &operator<<(std::ostream &out, const ProfileData &data)
         }
     }
     out << "], "
-        << "guids: [";
-    for (const auto &guid : data.guids)
-    {
-        out << '"' << guid << '"';
-        if (guid != *data.guids.rbegin())
-        {
-            out << ", ";
-        }
-    }
-    out << "instance: \"" << data.instance << "\", "
+        << "instance: \"" << data.instance << "\", "
         << "interval: " << data.interval << ", "
         << "keep_looking: " << data.keep_looking << ", "
+        << "poll_interval: " << data.poll_interval << ", "
+        << "connect_timeout: " << data.connect_timeout << ", "
+        << "timeout: " << data.timeout << ", "
+        << "low_speed_limit: " << data.low_speed_limit << ", "
+        << "low_speed_time: " << data.low_speed_time << ", "
+        << "max_run_time: " << data.max_run_time << ", "
+        << "max_check_interval: " << data.max_check_interval << ", "
+        << "arrivals: " << data.arrivals.size() << ", "
+        << "next_check: " << data.next_check << ", "
+        << "schedule: " << data.schedule << ", "
         << "max_size: " << data.max_size << ", "
+        << "template: \"" << data.post_template << "\", "
         << "skip: [";
     for (const auto &skip : data.skip)
     {
@@ -93,13 +104,17 @@ std::ostream &operator<<(std::ostream &out, const ProfileData &data)
         }
     }
     out << "], ";
-    out << "add_hashtags: " << data.add_hashtags;
+    out << "add_hashtags: " << data.add_hashtags << ", ";
+    out << "etag: \"" << data.etag << "\", "
+        << "last_modified: \"" << data.last_modified << '"';
 
     return out;
 }
 
-Config::Config(string profile_name)
+Config::Config(string profile_name, const bool dry_run,
+               const bool interactive)
     : profile{move(profile_name)}
+    , _dry_run{dry_run}
 {
     const fs::path filename = get_filename();
     BOOST_LOG_TRIVIAL(debug) << "Config filename is: " << filename;
@@ -112,13 +127,39 @@ Config::Config(string profile_name)
         rawjson >> _json;
         parse();
     }
-    else
+    else if (interactive)
     {
         generate();
     }
+    else
+    {
+        throw ConfigException{"Could not read " + filename.string() + "."};
+    }
+    compiled = CompiledProfile{profiledata};
+
+    // Migrates the GUIDs from the config file if the state file is new.
+    profiledata.guids.open(get_state_filename(), _dry_run);
+    BOOST_LOG_TRIVIAL(debug) << "GUIDs: " << profiledata.guids.size() << " of "
+                             << profiledata.guids.capacity();
+
+    journal.open(get_journal_filename(), _dry_run);
+    journal.restore(profiledata.guids);
+
+    read_feed_state();
+
+    // Remove the migrated state from the config file, once.
+    const Json::Value &data{_json[profile]};
+    if (!_dry_run && data.isObject()
+        && std::any_of(state_keys.begin(), state_keys.end(),
+                       [&data](const char *key)
+                       { return !data[key].isNull(); }))
+    {
+        BOOST_LOG_TRIVIAL(info) << "Removing migrated state from config file.";
+        write();
+    }
 }
 
-fs::path Config::get_config_dir() const
+fs::path Config::get_config_dir()
 {
     char *envdir = getenv("XDG_CONFIG_HOME");
     fs::path dir;
@@ -154,6 +195,26 @@ fs::path Config::get_filename() const
     return get_config_dir() /= "config-" + profile + ".json";
 }
 
+fs::path Config::get_state_filename() const
+{
+    return get_config_dir() /= "guids-" + profile + ".bin";
+}
+
+fs::path Config::get_journal_filename() const
+{
+    return get_config_dir() /= "journal-" + profile + ".bin";
+}
+
+fs::path Config::get_feed_state_filename() const
+{
+    return get_config_dir() /= "feed-" + profile + ".json";
+}
+
+fs::path Config::get_feedhosts_filename()
+{
+    return get_config_dir() /= "feedhosts.json";
+}
+
 void Config::generate()
 {
     string line;
@@ -239,7 +300,25 @@ void Config::parse()
     profiledata.append = _json[profile]["append"].asString();
     profiledata.feedurl = _json[profile]["feedurl"].asString();
     profiledata.fixes = jsonarray_to_stringlist(_json[profile]["fixes"]);
-    profiledata.guids = jsonarray_to_stringlist(_json[profile]["guids"]);
+    if (!_json[profile]["max_guids"].isNull())
+    {
+        const auto max_guids{_json[profile]["max_guids"].asUInt64()};
+        if (max_guids > GUIDHistory::max_capacity)
+        {
+            BOOST_LOG_TRIVIAL(warning)
+                << "max_guids is too big, using " << GUIDHistory::max_capacity
+                << '.';
+        }
+        profiledata.guids.set_capacity(max_guids);
+    }
+    // Only needed to migrate to the GUID state file.
+    if (!fs::exists(get_state_filename()))
+    {
+        for (const auto &guid : _json[profile]["guids"])
+        {
+            profiledata.guids.push(guid.asString());
+        }
+    }
     profiledata.instance = _json[profile]["instance"].asString();
     if (!_json[profile]["interval"].isNull())
     {
@@ -247,10 +326,52 @@ void Config::parse()
             _json[profile]["interval"].asUInt64());
     }
     profiledata.keep_looking = _json[profile]["keep_looking"].asBool();
+    if (!_json[profile]["poll_interval"].isNull())
+    {
+        profiledata.poll_interval = static_cast<uint32_t>(
+            _json[profile]["poll_interval"].asUInt64());
+    }
+    if (!_json[profile]["connect_timeout"].isNull())
+    {
+        profiledata.connect_timeout = static_cast<uint32_t>(
+            _json[profile]["connect_timeout"].asUInt64());
+    }
+    if (!_json[profile]["timeout"].isNull())
+    {
+        profiledata.timeout = static_cast<uint32_t>(
+            _json[profile]["timeout"].asUInt64());
+    }
+    if (!_json[profile]["low_speed_limit"].isNull())
+    {
+        profiledata.low_speed_limit = static_cast<uint32_t>(
+            _json[profile]["low_speed_limit"].asUInt64());
+    }
+    if (!_json[profile]["low_speed_time"].isNull())
+    {
+        profiledata.low_speed_time = static_cast<uint32_t>(
+            _json[profile]["low_speed_time"].asUInt64());
+    }
+    if (!_json[profile]["max_run_time"].isNull())
+    {
+        profiledata.max_run_time = static_cast<uint32_t>(
+            _json[profile]["max_run_time"].asUInt64());
+    }
+    if (!_json[profile]["max_check_interval"].isNull())
+    {
+        profiledata.max_check_interval = static_cast<uint32_t>(
+            _json[profile]["max_check_interval"].asUInt64());
+    }
+    for (const auto &arrival : _json[profile]["arrivals"])
+    {
+        profiledata.arrivals.push_back(arrival.asInt64());
+    }
+    profiledata.next_check = _json[profile]["next_check"].asInt64();
+    profiledata.schedule = _json[profile]["schedule"].asBool();
     if (!_json[profile]["max_size"].isNull())
     {
         profiledata.max_size = _json[profile]["max_size"].asUInt64();
     }
+    profiledata.post_template = _json[profile]["template"].asString();
     profiledata.skip = jsonarray_to_stringlist(_json[profile]["skip"]);
     profiledata.titles_as_cw = _json[profile]["titles_as_cw"].asBool();
     profiledata.titles_only = _json[profile]["titles_only"].asBool();
@@ -260,6 +381,8 @@ void Config::parse()
             {search, _json[profile]["replacements"][search].asString()});
     }
     profiledata.add_hashtags = _json[profile]["add_hashtags"].asBool();
+    profiledata.etag = _json[profile]["etag"].asString();
+    profiledata.last_modified = _json[profile]["last_modified"].asString();
 
     BOOST_LOG_TRIVIAL(debug) << "Read config: " << profiledata;
 }
@@ -269,13 +392,33 @@ void Config::write()
     _json[profile]["access_token"] = profiledata.access_token;
     _json[profile]["append"] = profiledata.append;
     _json[profile]["feedurl"] = profiledata.feedurl;
-    _json[profile]["guids"] = stringlist_to_jsonarray(profiledata.guids);
+    if (!_dry_run)
+    {
+        // The GUIDs and the state of the feed are in state files now.
+        for (const auto *key : state_keys)
+        {
+            _json[profile].removeMember(key);
+        }
+        save_state();
+    }
+    _json[profile]["max_guids"] = Json::UInt64{profiledata.guids.capacity()};
     _json[profile]["fixes"] = stringlist_to_jsonarray(profiledata.fixes);
     _json[profile]["instance"] = profiledata.instance;
     _json[profile]["interval"] = profiledata.interval;
     _json[profile]["keep_looking"] = profiledata.keep_looking;
-    _json[profile]["max_size"] = static_cast<Json::Value::UInt64>(
-        profiledata.max_size);
+    _json[profile]["poll_interval"] = profiledata.poll_interval;
+    _json[profile]["connect_timeout"] = profiledata.connect_timeout;
+    _json[profile]["timeout"] = profiledata.timeout;
+    _json[profile]["low_speed_limit"] = profiledata.low_speed_limit;
+    _json[profile]["low_speed_time"] = profiledata.low_speed_time;
+    _json[profile]["max_run_time"] = profiledata.max_run_time;
+    _json[profile]["max_check_interval"] = profiledata.max_check_interval;
+    _json[profile]["schedule"] = profiledata.schedule;
+    _json[profile]["max_size"] = Json::UInt64{profiledata.max_size};
+    if (!profiledata.post_template.empty())
+    {
+        _json[profile]["template"] = profiledata.post_template;
+    }
     _json[profile]["skip"] = stringlist_to_jsonarray(profiledata.skip);
     _json[profile]["titles_as_cw"] = profiledata.titles_as_cw;
     _json[profile]["titles_only"] = profiledata.titles_only;
@@ -294,6 +437,58 @@ void Config::write()
     BOOST_LOG_TRIVIAL(debug) << "Wrote config file.";
 }
 
+void Config::save_state()
+{
+    if (_dry_run)
+    {
+        return;
+    }
+
+    profiledata.guids.flush();
+    if (journal.pending().empty())
+    {
+        journal.clear();
+    }
+    write_feed_state();
+}
+
+void Config::read_feed_state()
+{
+    // Older versions kept the state in the config file, parse() read it.
+    const Json::Value state{read_state_file(get_feed_state_filename())};
+    if (state.isMember("etag"))
+    {
+        profiledata.etag = state["etag"].asString();
+        profiledata.last_modified = state["last_modified"].asString();
+    }
+    if (state.isMember("next_check"))
+    {
+        profiledata.arrivals.clear();
+        for (const auto &arrival : state["arrivals"])
+        {
+            profiledata.arrivals.push_back(arrival.asInt64());
+        }
+        profiledata.next_check = state["next_check"].asInt64();
+    }
+}
+
+void Config::write_feed_state()
+{
+    modify_state_file(get_feed_state_filename(),
+                      [this](Json::Value &state)
+                      {
+                          state["etag"] = profiledata.etag;
+                          state["last_modified"] = profiledata.last_modified;
+                          state["arrivals"] = Json::arrayValue;
+                          for (const auto arrival : profiledata.arrivals)
+                          {
+                              state["arrivals"].append(Json::Int64{arrival});
+                          }
+                          state["next_check"] = Json::Int64{
+                              profiledata.next_check};
+                      });
+}
+
 list<string> Config::jsonarray_to_stringlist(const Json::Value &jsonarray) const
 {
     list<string> stringlist;
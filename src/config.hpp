@@ -17,6 +17,10 @@
 #ifndef MASTORSS_CONFIG_HPP
 #define MASTORSS_CONFIG_HPP
 
+#include "compiled_profile.hpp"
+#include "guid_history.hpp"
+#include "post_journal.hpp"
+
 #include <boost/filesystem.hpp>
 #include <json/json.h>
 
@@ -46,16 +50,31 @@ struct ProfileData
     string append;
     string feedurl;
     list<string> fixes;
-    list<string> guids;
+    GUIDHistory guids;
     string instance;
     bool keep_looking{false};
     uint32_t interval{30};
+    uint32_t poll_interval{600};
+    uint32_t connect_timeout{10};
+    uint32_t timeout{60};
+    uint32_t low_speed_limit{10};
+    uint32_t low_speed_time{30};
+    uint32_t max_run_time{0};
+    uint32_t max_check_interval{24 * 60 * 60};
+    //! When new items were found, in seconds since the epoch. @since 0.14.0
+    list<std::int64_t> arrivals;
+    //! When the feed should be checked next. @since 0.14.0
+    std::int64_t next_check{0};
+    bool schedule{false};
     size_t max_size{500};
+    string post_template;
     list<string> skip;
     bool titles_as_cw{false};
     bool titles_only{false};
     list<pair<string, string>> replacements;
     bool add_hashtags{true};
+    string etag;
+    string last_modified;
 
     friend std::ostream &operator<<(std::ostream &out, const ProfileData &data);
 };
@@ -68,22 +87,62 @@ struct ProfileData
 class Config
 {
 public:
-    explicit Config(string profile_name);
+    /*!
+     *  @brief  Read the configuration of a profile or generate it.
+     *
+     *  @param  profile_name The name of the profile.
+     *  @param  dry_run      Don't change the GUID state file.
+     *  @param  interactive  Ask for a new configuration if there is none.
+     *                       Otherwise ConfigException is thrown.
+     *
+     *  @since  0.14.0
+     */
+    explicit Config(string profile_name, bool dry_run = false,
+                    bool interactive = true);
 
     const string profile;
     ProfileData profiledata;
-    constexpr static size_t max_guids{100};
+    //! The patterns of #profiledata. @since  0.14.0
+    CompiledProfile compiled;
+    //! The items that are about to be posted. @since  0.14.0
+    PostJournal journal;
 
     void write();
-    [[nodiscard]] fs::path get_config_dir() const;
+
+    /*!
+     *  @brief  Write the GUIDs, the journal and the state of the feed.
+     *
+     *  Unlike write(), the config file is left alone. Does nothing in a dry
+     *  run.
+     *
+     *  @since  0.14.0
+     */
+    void save_state();
+
+    //! Returns `true` if no files are changed. @since  0.14.0
+    [[nodiscard]] inline bool dry_run() const
+    {
+        return _dry_run;
+    }
+
+    [[nodiscard]] static fs::path get_config_dir();
+    //! The failures of feed hosts, shared by all profiles. @since  0.14.0
+    [[nodiscard]] static fs::path get_feedhosts_filename();
 
 private:
     Json::Value _json;
+    const bool _dry_run;
 
     [[nodiscard]] fs::path get_filename() const;
+    [[nodiscard]] fs::path get_state_filename() const;
+    [[nodiscard]] fs::path get_journal_filename() const;
+    [[nodiscard]] fs::path get_feed_state_filename() const;
     void generate();
     [[nodiscard]] string get_access_token(const string &instance) const;
     void parse();
+    //! Read the state of the feed, if it is not in the config file.
+    void read_feed_state();
+    void write_feed_state();
     list<string> jsonarray_to_stringlist(const Json::Value &jsonarray) const;
     Json::Value stringlist_to_jsonarray(const list<string> &stringlist) const;
 };
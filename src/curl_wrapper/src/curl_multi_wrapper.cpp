@@ -0,0 +1,128 @@
+/*  This file is part of curl_wrapper.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "curl_multi_wrapper.hpp"
+
+#include "curl_wrapper.hpp"
+#include "types.hpp"
+
+#include <curl/curl.h>
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+namespace curl_wrapper
+{
+
+using std::move;
+
+CURLMultiWrapper::CURLMultiWrapper()
+{
+    _multi = curl_multi_init();
+    if (_multi == nullptr)
+    {
+        throw std::runtime_error{"Failed to initialize curl multi handle."};
+    }
+}
+
+CURLMultiWrapper::~CURLMultiWrapper() noexcept
+{
+    for (const auto &entry : _transfers)
+    {
+        curl_multi_remove_handle(_multi, entry.first);
+    }
+    curl_multi_cleanup(_multi);
+}
+
+void CURLMultiWrapper::add_request(CURLWrapper &curl, const http_method method,
+                                   const string_view uri,
+                                   callback_type callback)
+{
+    CURL *handle{curl.get_curl_easy_handle()};
+    if (_transfers.find(handle) != _transfers.end())
+    {
+        throw std::runtime_error{"Handle is already in use."};
+    }
+
+    curl.prepare_request(method, uri);
+    check(curl_multi_add_handle(_multi, handle));
+    _transfers.insert({handle, {&curl, method, move(callback)}});
+}
+
+void CURLMultiWrapper::perform()
+{
+    while (!_transfers.empty())
+    {
+        int running{0};
+        check(curl_multi_perform(_multi, &running));
+        finish_transfers();
+
+        if (running > 0)
+        {
+            constexpr int timeout_ms{1000};
+            check(curl_multi_wait(_multi, nullptr, 0, timeout_ms, nullptr));
+        }
+    }
+}
+
+void CURLMultiWrapper::finish_transfers()
+{
+    int remaining{0};
+    while (CURLMsg *msg = curl_multi_info_read(_multi, &remaining))
+    {
+        if (msg->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+
+        CURL *handle{msg->easy_handle};
+        const CURLcode code{msg->data.result};
+        check(curl_multi_remove_handle(_multi, handle));
+
+        auto node{_transfers.extract(handle)};
+        if (node.empty())
+        {
+            continue;
+        }
+        auto &current{node.mapped()};
+
+        answer ret;
+        std::exception_ptr error;
+        try
+        {
+            ret = current.curl->finish_request(current.method, code);
+        }
+        catch (const CURLException &)
+        {
+            error = std::current_exception();
+        }
+
+        // The callback may queue a new request with the same handle.
+        current.callback(ret, error);
+    }
+}
+
+void CURLMultiWrapper::check(const CURLMcode code)
+{
+    if (code != CURLM_OK)
+    {
+        throw std::runtime_error{string("libcurl multi error: ")
+                                 += curl_multi_strerror(code)};
+    }
+}
+
+} // namespace curl_wrapper
@@ -0,0 +1,167 @@
+/*  This file is part of curl_wrapper.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CURL_WRAPPER_CURL_MULTI_WRAPPER_HPP
+#define CURL_WRAPPER_CURL_MULTI_WRAPPER_HPP
+
+#include "curl_wrapper.hpp"
+#include "types.hpp"
+
+#include <curl/curl.h>
+
+#include <exception>
+#include <functional>
+#include <map>
+#include <string_view>
+
+namespace curl_wrapper
+{
+
+using std::string_view;
+
+/*!
+ *  @brief  Runs requests of many CURLWrapper%s concurrently.
+ *
+ *  All transfers are driven from one thread by perform(), so the time needed
+ *  is roughly that of the slowest request instead of the sum of all of them.
+ *
+ *  @since  0.2.0
+ */
+class CURLMultiWrapper
+{
+public:
+    /*!
+     *  @brief  Called when a request is finished.
+     *
+     *  If the transfer failed, `error` holds a CURLException and the answer is
+     *  empty.
+     *
+     *  @since  0.2.0
+     */
+    using callback_type =
+        std::function<void(const answer &ret, std::exception_ptr error)>;
+
+    /*!
+     *  @brief  Initializes the multi handle.
+     *
+     *  May throw std::runtime_error.
+     *
+     *  @since  0.2.0
+     */
+    CURLMultiWrapper();
+
+    /*!
+     *  @brief  Removes all pending transfers and cleans up the multi handle.
+     *
+     *  @since  0.2.0
+     */
+    virtual ~CURLMultiWrapper() noexcept;
+
+    //! Copy constructor. @since  0.2.0
+    CURLMultiWrapper(const CURLMultiWrapper &other) = delete;
+
+    //! Move constructor @since 0.2.0
+    CURLMultiWrapper(CURLMultiWrapper &&other) noexcept = delete;
+
+    //! Copy assignment operator @since  0.2.0
+    CURLMultiWrapper &operator=(const CURLMultiWrapper &other) = delete;
+
+    //! Move assignment operator @since  0.2.0
+    CURLMultiWrapper &operator=(CURLMultiWrapper &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Returns pointer to the CURL multi handle.
+     *
+     *  For more information consult [curl_multi_setopt(3)]
+     *  (https://curl.haxx.se/libcurl/c/curl_multi_setopt.html).
+     *
+     *  @since  0.2.0
+     */
+    [[nodiscard]] inline CURLM *get_curl_multi_handle() const
+    {
+        return _multi;
+    }
+
+    /*!
+     *  @brief  Queue a HTTP request.
+     *
+     *  The request is started by perform(). `curl` must stay alive until the
+     *  callback was called and can only be used for one request at a time. It
+     *  is safe to queue new requests from within a callback.
+     *
+     *  May throw CURLException or std::runtime_error.
+     *
+     *  @param  curl     The handle to make the request with.
+     *  @param  method   The HTTP method.
+     *  @param  uri      The full URI.
+     *  @param  callback Called with the result.
+     *
+     *  @since  0.2.0
+     */
+    void add_request(CURLWrapper &curl, http_method method, string_view uri,
+                     callback_type callback);
+
+    /*!
+     *  @brief  Run until all queued requests are finished.
+     *
+     *  Exceptions thrown by callbacks are passed on; the remaining transfers
+     *  are continued by the next call.
+     *
+     *  May throw std::runtime_error.
+     *
+     *  @since  0.2.0
+     */
+    void perform();
+
+    /*!
+     *  @brief  Returns the number of unfinished requests.
+     *
+     *  @since  0.2.0
+     */
+    [[nodiscard]] inline size_t pending() const
+    {
+        return _transfers.size();
+    }
+
+private:
+    struct transfer
+    {
+        CURLWrapper *curl;
+        http_method method;
+        callback_type callback;
+    };
+
+    CURLM *_multi{};
+    std::map<CURL *, transfer> _transfers;
+
+    /*!
+     *  @brief  Call the callbacks of all finished transfers.
+     *
+     *  @since  0.2.0
+     */
+    void finish_transfers();
+
+    /*!
+     *  @brief  Throw std::runtime_error if command doesn't return CURLM_OK.
+     *
+     *  @since  0.2.0
+     */
+    static void check(CURLMcode code);
+};
+
+} // namespace curl_wrapper
+
+#endif // CURL_WRAPPER_CURL_MULTI_WRAPPER_HPP
@@ -0,0 +1,100 @@
+/*  This file is part of curl_wrapper.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "curl_pool.hpp"
+
+#include "curl_wrapper.hpp"
+
+#include <curl/curl.h>
+
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace curl_wrapper
+{
+
+void handle_returner::operator()(CURLWrapper *curl) const noexcept
+{
+    std::unique_ptr<CURLWrapper> handle{curl};
+    if (pool == nullptr)
+    {
+        return;
+    }
+    handle->set_body_callback({});
+
+    try
+    {
+        pool->_idle.push_back(std::move(handle));
+    }
+    catch (const std::exception &)
+    {
+        // Can't keep it, the handle is destroyed.
+    }
+}
+
+CURLPool::CURLPool()
+{
+    _share = curl_share_init();
+    if (_share == nullptr)
+    {
+        throw std::runtime_error{"Failed to initialize curl share handle."};
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900 // 7.57.0
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+}
+
+CURLPool::~CURLPool() noexcept
+{
+    _idle.clear();
+    curl_share_cleanup(_share);
+}
+
+CURLPool::lease_type CURLPool::lease()
+{
+    if (!_idle.empty())
+    {
+        lease_type curl{_idle.back().release(), handle_returner{this}};
+        _idle.pop_back();
+        curl->set_deadline(_deadline);
+        return curl;
+    }
+
+    auto curl{std::make_unique<CURLWrapper>()};
+    share(curl->get_curl_easy_handle());
+    curl->set_deadline(_deadline);
+    return lease_type{curl.release(), handle_returner{this}};
+}
+
+void CURLPool::share(CURL *handle)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const CURLcode code{curl_easy_setopt(handle, CURLOPT_SHARE, _share)};
+    if (code != CURLE_OK)
+    {
+        throw CURLException{code};
+    }
+}
+
+} // namespace curl_wrapper
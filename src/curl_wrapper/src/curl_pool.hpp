@@ -0,0 +1,160 @@
+/*  This file is part of curl_wrapper.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CURL_WRAPPER_CURL_POOL_HPP
+#define CURL_WRAPPER_CURL_POOL_HPP
+
+#include "curl_wrapper.hpp"
+
+#include <curl/curl.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace curl_wrapper
+{
+
+using std::vector;
+
+class CURLPool;
+
+/*!
+ *  @brief  Gives a leased CURLWrapper back to its CURLPool.
+ *
+ *  @since  0.2.0
+ */
+struct handle_returner
+{
+    CURLPool *pool{nullptr}; //!< The pool the handle belongs to.
+
+    //! Return the handle to the pool. @since  0.2.0
+    void operator()(CURLWrapper *curl) const noexcept;
+};
+
+/*!
+ *  @brief  A pool of CURLWrapper%s that share caches.
+ *
+ *  All handles share the DNS cache, the TLS session cache and the connection
+ *  cache, so requests to the same host reuse keep-alive connections no matter
+ *  which handle makes them. Handles keep the options of their previous use,
+ *  except for the body callback, which is removed, and the deadline, which is
+ *  the one of the pool.
+ *
+ *  Not thread-safe.
+ *
+ *  @since  0.2.0
+ */
+class CURLPool
+{
+public:
+    //! A handle that is returned to the pool when it goes out of scope.
+    using lease_type = std::unique_ptr<CURLWrapper, handle_returner>;
+
+    /*!
+     *  @brief  Initializes the share handle.
+     *
+     *  May throw std::runtime_error.
+     *
+     *  @since  0.2.0
+     */
+    CURLPool();
+
+    /*!
+     *  @brief  Cleans up all idle handles and the share handle.
+     *
+     *  All leased handles must have been returned before.
+     *
+     *  @since  0.2.0
+     */
+    virtual ~CURLPool() noexcept;
+
+    //! Copy constructor. @since  0.2.0
+    CURLPool(const CURLPool &other) = delete;
+
+    //! Move constructor @since 0.2.0
+    CURLPool(CURLPool &&other) noexcept = delete;
+
+    //! Copy assignment operator @since  0.2.0
+    CURLPool &operator=(const CURLPool &other) = delete;
+
+    //! Move assignment operator @since  0.2.0
+    CURLPool &operator=(CURLPool &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Returns pointer to the CURL share handle.
+     *
+     *  For more information consult [curl_share_setopt(3)]
+     *  (https://curl.haxx.se/libcurl/c/curl_share_setopt.html).
+     *
+     *  @since  0.2.0
+     */
+    [[nodiscard]] inline CURLSH *get_curl_share_handle() const
+    {
+        return _share;
+    }
+
+    /*!
+     *  @brief  Lease an idle handle or create a new one.
+     *
+     *  May throw CURLException or std::runtime_error.
+     *
+     *  @since  0.2.0
+     */
+    [[nodiscard]] lease_type lease();
+
+    /*!
+     *  @brief  Let a foreign easy handle use the shared caches.
+     *
+     *  The handle must be cleaned up before the pool is destroyed.
+     *
+     *  May throw CURLException.
+     *
+     *  @since  0.2.0
+     */
+    void share(CURL *handle);
+
+    /*!
+     *  @brief  Set the deadline of the handles leased from now on.
+     *
+     *  See CURLWrapper::set_deadline(). Foreign handles have to query it with
+     *  deadline().
+     *
+     *  @since  0.2.0
+     */
+    inline void set_deadline(optional<steady_clock::time_point> deadline)
+    {
+        _deadline = deadline;
+    }
+
+    //! Returns the deadline of the pool. @since  0.2.0
+    [[nodiscard]] inline optional<steady_clock::time_point> deadline() const
+    {
+        return _deadline;
+    }
+
+private:
+    friend struct handle_returner;
+
+    CURLSH *_share{};
+    optional<steady_clock::time_point> _deadline;
+    vector<std::unique_ptr<CURLWrapper>> _idle;
+};
+
+} // namespace curl_wrapper
+
+#endif // CURL_WRAPPER_CURL_POOL_HPP
@@ -21,16 +21,27 @@
 #include <curl/curl.h>
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <exception>
+#include <ratio>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 namespace curl_wrapper
 {
 
+using std::move;
+
 inline static std::atomic<std::uint64_t> curlwrapper_instances{0};
 
+// libcurl takes durations as long.
+// NOLINTNEXTLINE(google-runtime-int)
+using curl_milliseconds = std::chrono::duration<long, std::milli>;
+// NOLINTNEXTLINE(google-runtime-int)
+using curl_seconds = std::chrono::duration<long>;
+
 CURLWrapper::CURLWrapper()
 {
     if (curlwrapper_instances == 0)
@@ -69,6 +80,7 @@ CURLWrapper::CURLWrapper()
 CURLWrapper::~CURLWrapper() noexcept
 {
     curl_easy_cleanup(_connection);
+    curl_slist_free_all(_headers);
     --curlwrapper_instances;
 
     if (curlwrapper_instances == 0)
@@ -107,10 +119,76 @@ void CURLWrapper::set_proxy(const string_view proxy)
     check(curl_easy_setopt(_connection, CURLOPT_PROXY, proxy.data()));
 }
 
+void CURLWrapper::set_accept_encoding(const string_view encodings)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    check(curl_easy_setopt(_connection, CURLOPT_ACCEPT_ENCODING,
+                           string(encodings).c_str()));
+}
+
+void CURLWrapper::set_body_callback(body_callback_type callback)
+{
+    _body_callback = move(callback);
+}
+
+void CURLWrapper::set_headers(const vector<string> &headers)
+{
+    curl_slist *list{nullptr};
+    for (const auto &header : headers)
+    {
+        curl_slist *newlist{curl_slist_append(list, header.c_str())};
+        if (newlist == nullptr)
+        {
+            curl_slist_free_all(list);
+            throw std::runtime_error{"Failed to build header list."};
+        }
+        list = newlist;
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const auto code{curl_easy_setopt(_connection, CURLOPT_HTTPHEADER, list)};
+    curl_slist_free_all(_headers);
+    _headers = list;
+    check(code);
+}
+
 answer CURLWrapper::make_http_request(http_method method, string_view uri)
+{
+    prepare_request(method, uri);
+    return finish_request(method, curl_easy_perform(_connection));
+}
+
+void CURLWrapper::prepare_request(http_method method, string_view uri)
 {
     _buffer_headers.clear();
     _buffer_body.clear();
+    _size_body = 0;
+    _body_stopped = false;
+
+    milliseconds timeout{_timeout};
+    _deadline_limited = false;
+    if (_deadline)
+    {
+        using std::chrono::ceil;
+        const auto left{ceil<milliseconds>(*_deadline - steady_clock::now())};
+        if (left <= milliseconds{0})
+        {
+            throw CURLException{CURLE_OPERATION_TIMEDOUT, "Deadline reached.",
+                                true};
+        }
+        if (timeout <= milliseconds{0} || left < timeout)
+        {
+            timeout = left;
+            _deadline_limited = true;
+        }
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    check(curl_easy_setopt(_connection, CURLOPT_TIMEOUT_MS,
+                           curl_milliseconds{timeout}.count()));
+
+    // Reset method of previous request.
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(_connection, CURLOPT_CUSTOMREQUEST, nullptr);
 
     switch (method)
     {
@@ -168,10 +246,22 @@ answer CURLWrapper::make_http_request(http_method method, string_view uri)
 
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
     check(curl_easy_setopt(_connection, CURLOPT_URL, uri.data()));
+}
+
+answer CURLWrapper::finish_request(http_method method, const CURLcode code)
+{
+    if (code == CURLE_OPERATION_TIMEDOUT && _deadline_limited)
+    {
+        throw CURLException{code, "Deadline reached.", true};
+    }
 
     try
     {
-        check(curl_easy_perform(_connection));
+        // The body callback stopping the transfer is not an error.
+        if (!(code == CURLE_WRITE_ERROR && _body_stopped))
+        {
+            check(code);
+        }
     }
     catch (const CURLException &e)
     {
@@ -186,8 +276,22 @@ answer CURLWrapper::make_http_request(http_method method, string_view uri)
     long http_status{0}; // NOLINT(google-runtime-int)
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
     check(curl_easy_getinfo(_connection, CURLINFO_RESPONSE_CODE, &http_status));
-    return {static_cast<std::uint16_t>(http_status), _buffer_headers,
-            _buffer_body};
+
+#if LIBCURL_VERSION_NUM >= 0x073700 // 7.55.0
+    curl_off_t size_download{0};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    check(curl_easy_getinfo(_connection, CURLINFO_SIZE_DOWNLOAD_T,
+                            &size_download));
+#else
+    double size_download{0};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    check(curl_easy_getinfo(_connection, CURLINFO_SIZE_DOWNLOAD,
+                            &size_download));
+#endif
+
+    return {static_cast<std::uint16_t>(http_status), move(_buffer_headers),
+            move(_buffer_body), static_cast<std::uint64_t>(size_download),
+            _size_body};
 }
 
 void CURLWrapper::set_maxredirs(long redirections) // NOLINT(google-runtime-int)
@@ -202,12 +306,64 @@ void CURLWrapper::set_maxredirs(long redirections) // NOLINT(google-runtime-int)
     }
 }
 
+void CURLWrapper::set_connect_timeout(const milliseconds timeout)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    check(curl_easy_setopt(_connection, CURLOPT_CONNECTTIMEOUT_MS,
+                           curl_milliseconds{timeout}.count()));
+}
+
+void CURLWrapper::set_timeout(const milliseconds timeout)
+{
+    // Applied in prepare_request(), together with the deadline.
+    _timeout = timeout;
+}
+
+// NOLINTNEXTLINE(google-runtime-int)
+void CURLWrapper::set_low_speed_limit(const long bytes_per_second,
+                                      const seconds time)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    check(curl_easy_setopt(_connection, CURLOPT_LOW_SPEED_LIMIT,
+                           bytes_per_second));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    check(curl_easy_setopt(_connection, CURLOPT_LOW_SPEED_TIME,
+                           curl_seconds{time}.count()));
+}
+
+void CURLWrapper::set_deadline(optional<steady_clock::time_point> deadline)
+{
+    _deadline = deadline;
+}
+
 size_t CURLWrapper::writer_body(char *data, size_t size, size_t nmemb)
 {
     if (data == nullptr)
     {
         return 0;
     }
+    _size_body += size * nmemb;
+
+    if (_body_callback)
+    {
+        long http_status{0}; // NOLINT(google-runtime-int)
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        curl_easy_getinfo(_connection, CURLINFO_RESPONSE_CODE, &http_status);
+        try
+        {
+            if (!_body_callback(static_cast<std::uint16_t>(http_status),
+                                string_view(data, size * nmemb)))
+            {
+                _body_stopped = true;
+                return 0;
+            }
+        }
+        catch (...)
+        {
+            return 0; // Exceptions must not pass through libcurl.
+        }
+        return size * nmemb;
+    }
 
     _buffer_body.append(data, size * nmemb);
 
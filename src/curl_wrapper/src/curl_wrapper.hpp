@@ -21,15 +21,27 @@
 
 #include <curl/curl.h>
 
+#include <chrono>
+#include <cstdint>
 #include <exception>
+#include <functional>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace curl_wrapper
 {
 
+using std::optional;
 using std::string;
 using std::string_view;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+class CURLMultiWrapper;
 
 /*!
  *  @brief  Light wrapper around libcurl.
@@ -39,6 +51,17 @@ using std::string_view;
 class CURLWrapper
 {
 public:
+    /*!
+     *  @brief  Receives the body of a response in chunks.
+     *
+     *  Called with the HTTP status and the next part of the body. Return
+     *  `false` to stop the transfer. Must not throw.
+     *
+     *  @since  0.2.0
+     */
+    using body_callback_type =
+        std::function<bool(std::uint16_t status, string_view data)>;
+
     /*!
      *  @brief  Initializes curl and sets up connection.
      *
@@ -140,6 +163,50 @@ public:
      */
     void set_proxy(string_view proxy);
 
+    /*!
+     *  @brief  Enable transparent decompression of the response.
+     *
+     *  The body is decompressed while it is received, answer::body always
+     *  contains the decompressed data. For more information consult
+     *  [CURLOPT_ACCEPT_ENCODING(3)]
+     *  (https://curl.haxx.se/libcurl/c/CURLOPT_ACCEPT_ENCODING.html).
+     *
+     *  May throw CURLException.
+     *
+     *  @param  encodings Comma-separated list of encodings, like “gzip, br”.
+     *                    An empty string enables all encodings libcurl was
+     *                    built with.
+     *
+     *  @since  0.2.0
+     */
+    void set_accept_encoding(string_view encodings = "");
+
+    /*!
+     *  @brief  Pass the body to a callback instead of storing it.
+     *
+     *  answer::body stays empty while a callback is set. If the callback stops
+     *  the transfer, the request is still considered successful. Pass an empty
+     *  function to store the body again.
+     *
+     *  @since  0.2.0
+     */
+    void set_body_callback(body_callback_type callback);
+
+    /*!
+     *  @brief  Set additional request headers.
+     *
+     *  Replaces the headers that were set before. Pass an empty vector to
+     *  remove them. For more information consult [CURLOPT_HTTPHEADER(3)]
+     *  (https://curl.haxx.se/libcurl/c/CURLOPT_HTTPHEADER.html).
+     *
+     *  May throw CURLException or std::runtime_error.
+     *
+     *  @param  headers Headers in the form “Name: value”.
+     *
+     *  @since  0.2.0
+     */
+    void set_headers(const vector<string> &headers);
+
     /*!
      *  @brief  Make a HTTP request.
      *
@@ -170,11 +237,97 @@ public:
      */
     void set_maxredirs(long redirections); // NOLINT(google-runtime-int)
 
+    /*!
+     *  @brief  Set the maximum time to establish a connection.
+     *
+     *  For more information consult [CURLOPT_CONNECTTIMEOUT_MS(3)]
+     *  (https://curl.haxx.se/libcurl/c/CURLOPT_CONNECTTIMEOUT_MS.html).
+     *
+     *  May throw CURLException.
+     *
+     *  @param  timeout 0 means the libcurl default of 300 seconds.
+     *
+     *  @since  0.2.0
+     */
+    void set_connect_timeout(milliseconds timeout);
+
+    /*!
+     *  @brief  Set the maximum time a request may take.
+     *
+     *  Includes connecting and all redirections. For more information consult
+     *  [CURLOPT_TIMEOUT_MS(3)]
+     *  (https://curl.haxx.se/libcurl/c/CURLOPT_TIMEOUT_MS.html).
+     *
+     *  @param  timeout 0 means no limit.
+     *
+     *  @since  0.2.0
+     */
+    void set_timeout(milliseconds timeout);
+
+    /*!
+     *  @brief  Abort requests that are too slow.
+     *
+     *  A request is aborted if less than `bytes_per_second` are transferred
+     *  for `time`. For more information consult [CURLOPT_LOW_SPEED_LIMIT(3)]
+     *  (https://curl.haxx.se/libcurl/c/CURLOPT_LOW_SPEED_LIMIT.html).
+     *
+     *  May throw CURLException.
+     *
+     *  @param  bytes_per_second 0 disables the limit.
+     *  @param  time             0 disables the limit.
+     *
+     *  @since  0.2.0
+     */
+    // NOLINTNEXTLINE(google-runtime-int)
+    void set_low_speed_limit(long bytes_per_second, seconds time);
+
+    /*!
+     *  @brief  Set a point in time after which no request may run.
+     *
+     *  The timeout of each request is shortened so that it ends at the
+     *  deadline. Requests made after the deadline throw CURLException with
+     *  `CURLE_OPERATION_TIMEDOUT` without connecting. Pass {} to remove the
+     *  deadline.
+     *
+     *  @since  0.2.0
+     */
+    void set_deadline(optional<steady_clock::time_point> deadline);
+
 private:
+    friend class CURLMultiWrapper;
+
     CURL *_connection{};
+    curl_slist *_headers{};
     char _buffer_error[CURL_ERROR_SIZE]{};
     string _buffer_headers;
     string _buffer_body;
+    body_callback_type _body_callback;
+    std::uint64_t _size_body{0};
+    bool _body_stopped{false};
+    milliseconds _timeout{0};
+    optional<steady_clock::time_point> _deadline;
+    bool _deadline_limited{false}; //!< The deadline is the timeout.
+
+    /*!
+     *  @brief  Set method, URI and timeout and clear the buffers.
+     *
+     *  May throw CURLException.
+     *
+     *  @since  0.2.0
+     */
+    void prepare_request(http_method method, string_view uri);
+
+    /*!
+     *  @brief  Turn the result of a transfer into an answer.
+     *
+     *  May throw CURLException.
+     *
+     *  @param  method The HTTP method of the request.
+     *  @param  code   The result of the transfer.
+     *
+     *  @since  0.2.0
+     */
+    [[nodiscard]] answer finish_request(http_method method, CURLcode code);
 
     /*!
      *  @brief  libcurl write callback function.
@@ -235,15 +388,29 @@ public:
     /*!
      *  @brief Constructor with error code and error buffer.
      *
+     *  @param  deadline  The request was stopped by the deadline.
+     *
      *  @since  0.1.0
      */
-    explicit CURLException(const CURLcode code, string_view error_buffer)
+    explicit CURLException(const CURLcode code, string_view error_buffer,
+                           const bool deadline = false)
         : error_code{code}
+        , deadline_reached{deadline}
         , _error_message{error_buffer}
     {}
 
     const CURLcode error_code; //!< Error code from libcurl.
 
+    /*!
+     *  @brief  `true` if the request was stopped by the deadline.
+     *
+     *  See CURLWrapper::set_deadline(). The error code is
+     *  CURLE_OPERATION_TIMEDOUT then.
+     *
+     *  @since  0.2.0
+     */
+    const bool deadline_reached{false};
+
     /*!
      *  @brief  Error message.
      *
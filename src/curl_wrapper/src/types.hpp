@@ -56,6 +56,11 @@ struct answer
     std::uint16_t status{0}; //!< Status code.
     string headers;          //!< The headers of the response from the server.
     string body;             //!< The response from the server.
+    //! Size of the body as transferred, before decompression.
+    std::uint64_t size_download{0};
+    //! Size of the body after decompression, including what was passed to
+    //! the body callback.
+    std::uint64_t size_body{0};
 
     /*!
      *  @brief  Returns true if #status is 200.
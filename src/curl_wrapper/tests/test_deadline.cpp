@@ -0,0 +1,50 @@
+#include "curl_pool.hpp"
+#include "curl_wrapper.hpp"
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <exception>
+
+namespace curl_wrapper
+{
+
+SCENARIO("Requests after the deadline")
+{
+    bool exception = false;
+    CURLcode code{CURLE_OK};
+    bool deadline_reached{false};
+
+    WHEN("Making a request after the deadline of the pool")
+    {
+        try
+        {
+            CURLPool pool;
+            pool.set_deadline(steady_clock::now() - seconds{1});
+            const auto curl{pool.lease()};
+            curl->set_timeout(seconds{10});
+            curl->set_connect_timeout(seconds{5});
+            curl->set_low_speed_limit(1, seconds{10});
+            const auto answer{curl->make_http_request(http_method::GET,
+                                                      "http://localhost:9/")};
+        }
+        catch (const CURLException &e)
+        {
+            code = e.error_code;
+            deadline_reached = e.deadline_reached;
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("The request times out without connecting")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(code == CURLE_OPERATION_TIMEDOUT);
+            REQUIRE(deadline_reached);
+        }
+    }
+}
+
+} // namespace curl_wrapper
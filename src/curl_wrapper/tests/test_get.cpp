@@ -2,13 +2,16 @@
 
 #include <catch.hpp>
 
+#include <cstdint>
 #include <exception>
 #include <string>
+#include <string_view>
 
 namespace curl_wrapper
 {
 
 using std::string;
+using std::string_view;
 
 SCENARIO("HTTP GET", "[http]")
 {
@@ -38,4 +41,75 @@ SCENARIO("HTTP GET", "[http]")
     }
 }
 
+SCENARIO("HTTP GET with compression", "[http]")
+{
+    const string uri{"https://schlomp.space/api/v1/version"};
+
+    bool exception = false;
+    answer ret;
+
+    WHEN("GETing " + uri)
+    {
+        try
+        {
+            CURLWrapper curl;
+            curl.set_accept_encoding();
+            ret = curl.make_http_request(http_method::GET, uri);
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        AND_THEN("We get the decompressed answer")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(ret.body.substr(0, 11) == R"({"version":)");
+            REQUIRE(ret.size_download > 0);
+            REQUIRE(ret.size_body == ret.body.size());
+        }
+    }
+}
+
+SCENARIO("HTTP GET with body callback", "[http]")
+{
+    const string uri{"https://schlomp.space/api/v1/version"};
+
+    bool exception = false;
+    std::uint16_t status{0};
+    string received;
+    answer ret;
+
+    WHEN("GETing " + uri + " and stopping after the first chunk")
+    {
+        try
+        {
+            CURLWrapper curl;
+            curl.set_body_callback(
+                [&](const std::uint16_t http_status, const string_view data)
+                {
+                    status = http_status;
+                    received = data;
+                    return false;
+                });
+            ret = curl.make_http_request(http_method::GET, uri);
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        AND_THEN("The callback got the body instead of the answer")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(status == 200);
+            REQUIRE(received.substr(0, 11) == R"({"version":)");
+            REQUIRE(ret.body.empty());
+            REQUIRE(ret.size_body == received.size());
+        }
+    }
+}
+
 } // namespace curl_wrapper
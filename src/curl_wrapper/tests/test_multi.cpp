@@ -0,0 +1,95 @@
+#include "curl_multi_wrapper.hpp"
+#include "curl_wrapper.hpp"
+
+#include <catch.hpp>
+
+#include <exception>
+#include <string>
+
+namespace curl_wrapper
+{
+
+using std::string;
+
+SCENARIO("Concurrent HTTP GET", "[http]")
+{
+    const string uri{"https://schlomp.space/api/v1/version"};
+
+    bool exception = false;
+    string answer1;
+    string answer2;
+
+    WHEN("GETing " + uri + " twice at the same time")
+    {
+        try
+        {
+            CURLMultiWrapper multi;
+            CURLWrapper curl1;
+            CURLWrapper curl2;
+            multi.add_request(curl1, http_method::GET, uri,
+                              [&](const auto &ret, const auto error)
+                              {
+                                  exception = exception || error;
+                                  answer1 = ret.body;
+                              });
+            multi.add_request(curl2, http_method::GET, uri,
+                              [&](const auto &ret, const auto error)
+                              {
+                                  exception = exception || error;
+                                  answer2 = ret.body;
+                              });
+            multi.perform();
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        AND_THEN("We get the right answers")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(answer1.substr(0, 11) == R"({"version":)");
+            REQUIRE(answer2.substr(0, 11) == R"({"version":)");
+        }
+    }
+}
+
+SCENARIO("Failed transfer in multi handle")
+{
+    const string uri{"http://[::1]:1/"};
+
+    bool exception = false;
+    bool error = false;
+    size_t calls = 0;
+
+    WHEN("GETing " + uri)
+    {
+        try
+        {
+            CURLMultiWrapper multi;
+            CURLWrapper curl;
+            multi.add_request(curl, http_method::GET, uri,
+                              [&](const auto &, const auto err)
+                              {
+                                  ++calls;
+                                  error = static_cast<bool>(err);
+                              });
+            multi.perform();
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        AND_THEN("The error is passed to the callback")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(calls == 1);
+            REQUIRE(error);
+        }
+    }
+}
+
+} // namespace curl_wrapper
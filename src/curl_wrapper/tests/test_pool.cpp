@@ -0,0 +1,47 @@
+#include "curl_pool.hpp"
+
+#include <catch.hpp>
+
+#include <exception>
+
+namespace curl_wrapper
+{
+
+SCENARIO("Lease handles from a pool")
+{
+    bool exception = false;
+    const CURLWrapper *first{nullptr};
+    const CURLWrapper *second{nullptr};
+    const CURLWrapper *third{nullptr};
+
+    WHEN("Leasing handles")
+    {
+        try
+        {
+            CURLPool pool;
+            {
+                const auto curl{pool.lease()};
+                first = curl.get();
+            }
+            const auto curl1{pool.lease()};
+            const auto curl2{pool.lease()};
+            second = curl1.get();
+            third = curl2.get();
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        AND_THEN("Returned handles are reused")
+        AND_THEN("Leased handles are not handed out twice")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(first == second);
+            REQUIRE(second != third);
+        }
+    }
+}
+
+} // namespace curl_wrapper
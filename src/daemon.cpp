@@ -0,0 +1,379 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "daemon.hpp"
+
+#include "exceptions.hpp"
+
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <csignal>
+#include <exception>
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace mastorss
+{
+using std::exception;
+using std::max;
+using std::min;
+using std::move;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+using std::this_thread::sleep_until;
+
+namespace
+{
+volatile std::sig_atomic_t stop_requested{0};
+
+extern "C" void request_stop(int /*signal*/)
+{
+    stop_requested = 1;
+}
+
+//! Convert a wall clock time to the clock the daemon waits with.
+steady_clock::time_point to_steady(const system_clock::time_point time)
+{
+    return steady_clock::now() + (time - system_clock::now());
+}
+} // namespace
+
+Daemon::Profile::Profile(const string &name, curl_wrapper::CURLPool &pool,
+                         const bool dry_run)
+    : cfg{name, dry_run, false}
+    , watchwords{Document::load_watchwords(cfg)}
+    , masto{cfg.profile, cfg.profiledata, cfg.compiled, pool}
+    , queue{cfg.journal.pending()} // Resume an interrupted run.
+    , next_fetch{
+          to_steady(system_clock::from_time_t(cfg.profiledata.next_check))}
+{}
+
+Daemon::Daemon(const bool dry_run)
+    : _dry_run{dry_run}
+    , _breaker{dry_run ? fs::path{} : Config::get_feedhosts_filename()}
+{
+    load_profiles();
+}
+
+void Daemon::run()
+{
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+
+    while (stop_requested == 0)
+    {
+        const auto now{steady_clock::now()};
+        vector<Profile *> due;
+        for (auto &profile : _profiles)
+        {
+            if (!profile.queue.empty())
+            {
+                if (profile.next_post <= now)
+                {
+                    post(profile);
+                }
+            }
+            else if (profile.next_fetch <= now)
+            {
+                due.push_back(&profile);
+            }
+        }
+
+        const auto groups{fetch(due)};
+        if (_multi.pending() > 0)
+        {
+            _multi.perform();
+            for (const auto &group : groups)
+            {
+                parse(group);
+            }
+        }
+        sync_journals();
+
+        // Wake up at least once a second to notice signals.
+        sleep_until(min(next_due(), steady_clock::now() + seconds(1)));
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "Stopping daemon.";
+    for (auto &profile : _profiles)
+    {
+        save(profile);
+    }
+}
+
+void Daemon::load_profiles()
+{
+    const string prefix{"config-"};
+    const string suffix{".json"};
+
+    for (const auto &entry : fs::directory_iterator(Config::get_config_dir()))
+    {
+        const string filename{entry.path().filename().string()};
+        if (filename.size() <= prefix.size() + suffix.size()
+            || filename.compare(0, prefix.size(), prefix) != 0
+            || filename.compare(filename.size() - suffix.size(),
+                                suffix.size(), suffix)
+                   != 0)
+        {
+            continue;
+        }
+
+        const string name{filename.substr(
+            prefix.size(), filename.size() - prefix.size() - suffix.size())};
+        BOOST_LOG_TRIVIAL(debug) << "Loading profile: " << name;
+        try
+        {
+            _profiles.emplace_back(name, _pool, _dry_run);
+        }
+        catch (const std::exception &e)
+        {
+            // One broken profile must not stop the others.
+            BOOST_LOG_TRIVIAL(error)
+                << name << ": Skipping profile: " << e.what();
+        }
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "Loaded " << _profiles.size() << " profiles.";
+}
+
+vector<Daemon::Group> Daemon::fetch(const vector<Profile *> &due)
+{
+    std::map<string, Group> feeds;
+    for (auto *profile : due)
+    {
+        auto &data{profile->cfg.profiledata};
+        profile->next_fetch = steady_clock::now()
+                              + seconds(data.poll_interval);
+        feeds[Document::normalize_url(data.feedurl)].push_back(profile);
+    }
+
+    vector<Group> groups;
+    for (auto &[url, group] : feeds)
+    {
+        auto &leader{*group.front()};
+        auto &data{leader.cfg.profiledata};
+
+        const string host{CircuitBreaker::host_of(data.feedurl)};
+        if (const auto probe{_breaker.blocked(host)})
+        {
+            for (auto *profile : group)
+            {
+                profile->next_fetch = max(profile->next_fetch,
+                                          to_steady(*probe));
+            }
+            BOOST_LOG_TRIVIAL(debug) << leader.cfg.profile << ": Skipping "
+                                     << host << " after repeated failures.";
+            continue;
+        }
+
+        try
+        {
+            if (group.size() == 1)
+            {
+                leader.doc = std::make_unique<Document>(leader.cfg, _pool,
+                                                        _multi);
+            }
+            else
+            {
+                size_t max_items{0};
+                for (const auto *profile : group)
+                {
+                    const auto &other{profile->cfg.profiledata};
+                    max_items = max(max_items, other.guids.capacity());
+                    if (other.etag != data.etag
+                        || other.last_modified != data.last_modified)
+                    {
+                        // 304 would be wrong for the other profile.
+                        data.etag.clear();
+                        data.last_modified.clear();
+                    }
+                }
+                BOOST_LOG_TRIVIAL(debug)
+                    << leader.cfg.profile << ": Downloading " << url
+                    << " for " << group.size() << " profiles.";
+                leader.doc = std::make_unique<Document>(leader.cfg, _pool,
+                                                        _multi, max_items);
+            }
+            groups.push_back(move(group));
+        }
+        catch (const exception &e)
+        {
+            BOOST_LOG_TRIVIAL(error) << leader.cfg.profile << ": "
+                                     << e.what();
+        }
+    }
+
+    return groups;
+}
+
+void Daemon::parse(const Group &group)
+{
+    auto &leader{*group.front()};
+    if (!leader.doc)
+    {
+        return;
+    }
+
+    const string host{CircuitBreaker::host_of(leader.cfg.profiledata.feedurl)};
+    const auto feed{(group.size() > 1) ? leader.doc->share() : nullptr};
+    bool host_ok{parse(leader)};
+    for (auto it{group.begin() + 1}; it != group.end(); ++it)
+    {
+        auto &profile{**it};
+        profile.doc = std::make_unique<Document>(profile.cfg, feed);
+        host_ok = parse(profile) && host_ok;
+    }
+
+    if (host_ok)
+    {
+        _breaker.succeeded(host);
+    }
+    else
+    {
+        _breaker.failed(host);
+    }
+}
+
+bool Daemon::parse(Profile &profile)
+{
+    bool host_ok{true};
+    try
+    {
+        profile.doc->parse(profile.watchwords);
+        profile.queue = move(profile.doc->new_items);
+        profile.cfg.journal.append(profile.queue);
+        profile.unsaved = true; // At least the next check changed.
+        BOOST_LOG_TRIVIAL(debug) << profile.cfg.profile << ": "
+                                 << profile.queue.size() << " new items.";
+    }
+    catch (const HTTPException &e)
+    {
+        host_ok = !CircuitBreaker::host_failure(e);
+        BOOST_LOG_TRIVIAL(error) << profile.cfg.profile << ": " << e.what();
+    }
+    catch (const curl_wrapper::CURLException &e)
+    {
+        host_ok = !CircuitBreaker::host_failure(e);
+        BOOST_LOG_TRIVIAL(error) << profile.cfg.profile << ": " << e.what();
+    }
+    catch (const exception &e)
+    {
+        BOOST_LOG_TRIVIAL(error) << profile.cfg.profile << ": " << e.what();
+    }
+    profile.doc.reset();
+
+    // Don't check the feed before it is due.
+    profile.next_fetch = max(profile.next_fetch,
+                             to_steady(system_clock::from_time_t(
+                                 profile.cfg.profiledata.next_check)));
+
+    return host_ok;
+}
+
+void Daemon::post(Profile &profile)
+{
+    auto &data{profile.cfg.profiledata};
+
+    // Retries of an item use the post that was reserved for its first try.
+    if (!_dry_run && !profile.reserved)
+    {
+        if (const auto renewal{profile.masto.reserve_post()})
+        {
+            // Let the other profiles go first.
+            profile.next_post = to_steady(*renewal);
+            BOOST_LOG_TRIVIAL(info) << profile.cfg.profile
+                                    << ": Rate limit reached, waiting.";
+            return;
+        }
+        profile.reserved = true;
+    }
+
+    try
+    {
+        if (const auto retry{
+                profile.masto.try_post_item(profile.queue.front(), _dry_run)})
+        { // Don't block the other profiles while waiting.
+            profile.next_post = steady_clock::now() + *retry;
+            return;
+        }
+        profile.reserved = false;
+        // Synced together with the other profiles by sync_journals().
+        profile.cfg.journal.commit(profile.queue.front().guid);
+        profile.queue.pop_front();
+        profile.unsaved = true;
+    }
+    catch (const exception &e)
+    {
+        profile.reserved = false;
+        BOOST_LOG_TRIVIAL(error) << profile.cfg.profile << ": " << e.what();
+        // Try again with the next fetch, which must not be answered with 304.
+        profile.queue.clear();
+        profile.cfg.journal.discard();
+        data.etag.clear();
+        data.last_modified.clear();
+        profile.unsaved = true;
+    }
+
+    profile.next_post = steady_clock::now()
+                        + seconds(_dry_run ? 0 : data.interval);
+    if (profile.queue.empty())
+    {
+        save(profile);
+    }
+}
+
+void Daemon::save(Profile &profile)
+{
+    if (!profile.unsaved || _dry_run)
+    {
+        return;
+    }
+
+    profile.cfg.save_state();
+    profile.unsaved = false;
+}
+
+void Daemon::sync_journals()
+{
+    for (auto &profile : _profiles)
+    {
+        try
+        {
+            profile.cfg.journal.sync();
+        }
+        catch (const exception &e)
+        {
+            BOOST_LOG_TRIVIAL(error)
+                << profile.cfg.profile << ": " << e.what();
+        }
+    }
+}
+
+steady_clock::time_point Daemon::next_due() const
+{
+    auto due{steady_clock::time_point::max()};
+    for (const auto &profile : _profiles)
+    {
+        due = min(due, profile.queue.empty() ? profile.next_fetch
+                                             : profile.next_post);
+    }
+
+    return due;
+}
+} // namespace mastorss
@@ -0,0 +1,108 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_DAEMON_HPP
+#define MASTORSS_DAEMON_HPP
+
+#include "circuit_breaker.hpp"
+#include "config.hpp"
+#include "curl_multi_wrapper.hpp"
+#include "curl_pool.hpp"
+#include "document.hpp"
+#include "mastoapi.hpp"
+#include "watchword_matcher.hpp"
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mastorss
+{
+using std::list;
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+/*!
+ *  @brief  Runs all profiles from one process.
+ *
+ *  Every profile in the configuration directory is loaded once and kept in
+ *  memory. Feeds are checked every `poll_interval` seconds and new items are
+ *  posted every `interval` seconds, without blocking the other profiles. Feeds
+ *  that are due at the same time are downloaded concurrently, and profiles with
+ *  the same feed download it only once. Feed hosts that failed repeatedly are
+ *  skipped until their next probe. Items that were not posted when the daemon
+ *  stopped are posted after the next start.
+ *
+ *  @since  0.14.0
+ */
+class Daemon
+{
+public:
+    explicit Daemon(bool dry_run);
+
+    /*!
+     *  @brief  Run until SIGINT or SIGTERM is received.
+     *
+     *  @since  0.14.0
+     */
+    void run();
+
+private:
+    struct Profile
+    {
+        Profile(const string &name, curl_wrapper::CURLPool &pool,
+                bool dry_run);
+
+        Config cfg;
+        WatchwordMatcher watchwords;
+        MastoAPI masto;
+        std::unique_ptr<Document> doc;
+        list<Item> queue;
+        steady_clock::time_point next_fetch;
+        steady_clock::time_point next_post;
+        bool unsaved{false};
+        //! The front of #queue has a post from the rate limit.
+        bool reserved{false};
+    };
+
+    const bool _dry_run;
+    curl_wrapper::CURLPool _pool;
+    curl_wrapper::CURLMultiWrapper _multi;
+    CircuitBreaker _breaker;
+    list<Profile> _profiles;
+
+    //! Profiles that share one download, the first one downloads.
+    using Group = vector<Profile *>;
+
+    void load_profiles();
+    //! Queue the downloads of the due profiles, grouped by feed.
+    [[nodiscard]] vector<Group> fetch(const vector<Profile *> &due);
+    void parse(const Group &group);
+    //! Returns `false` if the feed host failed.
+    bool parse(Profile &profile);
+    void post(Profile &profile);
+    void save(Profile &profile);
+
+    //! Sync the commits of all profiles with one fsync per journal.
+    void sync_journals();
+    [[nodiscard]] steady_clock::time_point next_due() const;
+};
+} // namespace mastorss
+
+#endif // MASTORSS_DAEMON_HPP
@@ -18,56 +18,176 @@
 
 #include "curl_wrapper.hpp"
 #include "exceptions.hpp"
+#include "html_to_text.hpp"
+#include "poll_schedule.hpp"
+#include "rss_parser.hpp"
+#include "util.hpp"
 #include "version.hpp"
 
 #include <boost/log/trivial.hpp>
-#include <boost/property_tree/xml_parser.hpp>
-#include <boost/regex.hpp>
 #include <json/json.h>
 #include <mastodonpp/mastodonpp.hpp>
 
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <fstream>
+#include <memory>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 namespace mastorss
 {
-using boost::regex;
-using boost::regex_replace;
-using std::any_of;
+using std::exception_ptr;
 using std::ifstream;
-using std::istringstream;
+using std::max;
 using std::move;
+using std::optional;
 using std::string;
+using std::string_view;
 using std::stringstream;
 using std::transform;
+using std::vector;
+using std::chrono::seconds;
+using std::chrono::system_clock;
 
-bool operator!=(const Item &a, const Item &b)
+namespace
 {
-    return a.guid != b.guid;
+// Returns the element or throws ParseException if it is missing.
+string &get_element(optional<string> &element, const string_view name)
+{
+    if (!element)
+    {
+        throw ParseException{"Item without <" + string(name) + ">."};
+    }
+    return *element;
 }
+} // namespace
 
-Document::Document(Config &cfg)
+Document::Document(Config &cfg, curl_wrapper::CURLPool &pool)
     : _cfg{cfg}
     , _profiledata{_cfg.profiledata}
+    , _curl{pool.lease()}
 {
     download();
 }
 
+Document::Document(Config &cfg, curl_wrapper::CURLPool &pool,
+                   curl_wrapper::CURLMultiWrapper &multi)
+    : _cfg{cfg}
+    , _profiledata{_cfg.profiledata}
+    , _curl{pool.lease()}
+    , _multi{&multi}
+{
+    download();
+}
+
+Document::Document(Config &cfg, curl_wrapper::CURLPool &pool,
+                   curl_wrapper::CURLMultiWrapper &multi,
+                   const size_t max_items)
+    : _cfg{cfg}
+    , _profiledata{_cfg.profiledata}
+    , _curl{pool.lease()}
+    , _multi{&multi}
+    , _shared{std::make_shared<SharedFeed>()}
+    , _max_shared{max_items}
+{
+    download();
+}
+
+Document::Document(Config &cfg, std::shared_ptr<const SharedFeed> feed)
+    : _cfg{cfg}
+    , _profiledata{_cfg.profiledata}
+    , _feed{move(feed)}
+{}
+
 void Document::download(const string &uri, const bool temp_redirect)
 {
     namespace cw = curl_wrapper;
 
     BOOST_LOG_TRIVIAL(debug) << "Downloading <" << uri << "> …";
-    cw::CURLWrapper curl;
-    curl.set_useragent(string("mastorss/") += version);
-    curl.set_maxredirs(0);
+    _curl->set_useragent(string("mastorss/") += version);
+    _curl->set_maxredirs(0);
+    _curl->set_accept_encoding();
+    _curl->set_connect_timeout(seconds{_profiledata.connect_timeout});
+    _curl->set_timeout(seconds{_profiledata.timeout});
+    _curl->set_low_speed_limit(_profiledata.low_speed_limit,
+                               seconds{_profiledata.low_speed_time});
+
+    vector<string> headers;
+    if (!_profiledata.etag.empty())
+    {
+        headers.push_back("If-None-Match: " + _profiledata.etag);
+    }
+    if (!_profiledata.last_modified.empty())
+    {
+        headers.push_back("If-Modified-Since: " + _profiledata.last_modified);
+    }
+    _curl->set_headers(headers);
 
-    const auto answer{curl.make_http_request(cw::http_method::GET, uri)};
+    // Every request starts a new document, redirects have their own body.
+    _parser.emplace(
+        [this](RSSParser::item &rssitem)
+        {
+            if (_shared)
+            { // The other profiles decide for themselves.
+                _shared->items.push_back(move(rssitem));
+                return _shared->items.size() < _max_shared;
+            }
+            return select_item(rssitem);
+        });
+    if (_shared)
+    {
+        _shared->items.clear();
+    }
+    _selected.clear();
+    _counter = 0;
+    _arrived = false;
+    _curl->set_body_callback([this](const std::uint16_t status,
+                                    const string_view data)
+                             { return feed(status, data); });
+
+    if (_multi != nullptr)
+    {
+        // clang-format off
+        _multi->add_request(
+            *_curl, cw::http_method::GET, uri,
+            [this, temp_redirect](const cw::answer &answer,
+                                  const exception_ptr error)
+            {
+                if (error)
+                {
+                    _error = error;
+                    return;
+                }
+                try
+                {
+                    handle_answer(answer, temp_redirect);
+                }
+                catch (const std::exception &)
+                {
+                    _error = std::current_exception();
+                }
+            });
+        // clang-format on
+        return;
+    }
+
+    handle_answer(_curl->make_http_request(cw::http_method::GET, uri),
+                  temp_redirect);
+}
 
+void Document::handle_answer(const curl_wrapper::answer &answer,
+                             const bool temp_redirect)
+{
     BOOST_LOG_TRIVIAL(debug) << "Got response: " << answer.status;
     BOOST_LOG_TRIVIAL(debug) << "Got Headers:";
     BOOST_LOG_TRIVIAL(debug) << answer.headers;
@@ -76,8 +196,30 @@ void Document::download(const string &uri, const bool temp_redirect)
     {
     case 200:
     {
-        _raw_doc = answer.body;
         BOOST_LOG_TRIVIAL(debug) << "Downloaded feed: " << _profiledata.feedurl;
+        BOOST_LOG_TRIVIAL(debug)
+            << "Transferred " << answer.size_download
+            << " bytes, decompressed to " << answer.size_body << " bytes.";
+        if (_parser->stopped())
+        {
+            BOOST_LOG_TRIVIAL(debug) << "Stopped the transfer early.";
+        }
+        _poll_hint = max(_poll_hint, http_poll_hint(answer));
+        if (_error)
+        {
+            break; // Don't remember validators of a feed we couldn't parse.
+        }
+
+        _profiledata.etag = answer.get_header("ETag");
+        _profiledata.last_modified = answer.get_header("Last-Modified");
+        break;
+    }
+    case 304:
+    {
+        _poll_hint = max(_poll_hint, http_poll_hint(answer));
+        _not_modified = true;
+        BOOST_LOG_TRIVIAL(debug) << "Feed not modified: "
+                                 << _profiledata.feedurl;
         break;
     }
     case 301:
@@ -92,6 +234,8 @@ void Document::download(const string &uri, const bool temp_redirect)
         {
             throw HTTPException{answer.status};
         }
+        _profiledata.etag.clear();
+        _profiledata.last_modified.clear();
 
         // clang-format off
         BOOST_LOG_TRIVIAL(debug) << "Feed has new location (permanent): "
@@ -121,6 +265,13 @@ temporary_redirect:
     }
     default:
     {
+        // Come back when the server asks us to.
+        if (const auto retry_after{
+                parse_retry_after(answer.get_header("Retry-After"))})
+        {
+            _profiledata.next_check = system_clock::to_time_t(
+                system_clock::now() + *retry_after);
+        }
         throw HTTPException{answer.status};
     }
     }
@@ -131,134 +282,209 @@ void Document::download()
     download(_profiledata.feedurl);
 }
 
-void Document::parse()
+bool Document::feed(const std::uint16_t status, const string_view data)
 {
-    if (_profiledata.add_hashtags)
+    if (status != 200)
     {
-        parse_watchwords();
+        return true; // We only need the headers of redirects.
     }
-    pt::ptree tree;
-    istringstream iss{_raw_doc};
-    pt::read_xml(iss, tree);
 
-    if (tree.front().first == "rss")
+    try
     {
-        BOOST_LOG_TRIVIAL(debug) << "RSS detected.";
-        parse_rss(tree);
+        return _parser->feed(data);
+    }
+    catch (const std::exception &)
+    {
+        _error = std::current_exception();
+        return false;
+    }
+}
+
+void Document::parse(const WatchwordMatcher &watchwords)
+{
+    if (_shared)
+    {
+        static_cast<void>(share());
+    }
+    if (_feed)
+    {
+        select_shared();
     }
     else
     {
-        throw ParseException{"Could not detect type of feed."};
+        finish_download();
+    }
+
+    for (auto &rssitem : _selected)
+    {
+        new_items.push_back(make_item(rssitem, watchwords));
     }
+    _selected.clear();
+
+    const auto now{system_clock::now()};
+    plan_next_check(_profiledata, _arrived, _poll_hint, now);
+    BOOST_LOG_TRIVIAL(debug)
+        << "Next check of the feed in "
+        << _profiledata.next_check - system_clock::to_time_t(now)
+        << " seconds.";
 }
 
-void Document::parse_rss(const pt::ptree &tree)
+std::shared_ptr<const SharedFeed> Document::share()
 {
-    size_t counter{0};
-    for (const auto &child : tree.get_child("rss.channel"))
+    if (_feed)
     {
-        if (counter == Config::max_guids)
-        {
-            BOOST_LOG_TRIVIAL(debug)
-                << "Maximum number of items reached. Stopped parsing.";
-            break;
-        }
-        ++counter;
-        if (child.first == "item")
-        {
-            const auto &rssitem = child.second;
+        return _feed;
+    }
 
-            string guid{rssitem.get<string>("guid", "")};
-            if (guid.empty()) // We hope either <guid> or <link> are present.
-            {
-                guid = rssitem.get<string>("link");
-            }
-            if (any_of(_profiledata.guids.begin(), _profiledata.guids.end(),
-                       [&](const auto &old_guid) { return guid == old_guid; }))
-            {
-                // clang-format off
-                BOOST_LOG_TRIVIAL(debug) << "Found already posted GUID: "
-                                         << guid;
-                // clang-format on
-                if (_profiledata.keep_looking)
-                {
-                    continue;
-                }
+    try
+    {
+        finish_download();
+    }
+    catch (const std::exception &)
+    {
+        _shared->error = std::current_exception();
+    }
+    _shared->not_modified = _not_modified;
+    _shared->feedurl = _profiledata.feedurl;
+    _shared->etag = _profiledata.etag;
+    _shared->last_modified = _profiledata.last_modified;
+    _shared->poll_hint = _poll_hint;
+    _feed = move(_shared);
+
+    return _feed;
+}
 
-                BOOST_LOG_TRIVIAL(debug) << "Stopped parsing.";
-                break;
-            }
+void Document::finish_download()
+{
+    if (_error)
+    {
+        std::rethrow_exception(_error);
+    }
+    if (_not_modified)
+    {
+        return;
+    }
 
-            string title{rssitem.get<string>("title")};
-            if (any_of(_profiledata.skip.begin(), _profiledata.skip.end(),
-                       [&title](const string &skip)
-                       // clang-format off
-                       { return title.substr(0, skip.size()) == skip; }))
-            // clang-format on
-            {
-                BOOST_LOG_TRIVIAL(debug) << "Skipped GUID: " << guid;
-                continue;
-            }
+    _parser->finish();
+    const auto &channel{_parser->get_channel()};
+    _poll_hint = max(_poll_hint,
+                     feed_poll_hint(channel.ttl.value_or(""),
+                                    channel.update_period.value_or(""),
+                                    channel.update_frequency.value_or("")));
+}
 
-            Item item;
-            item.description = [&]
-            // clang-format off
-            {
-                string desc{rssitem.get<string>("description")};
-                for (const auto &fix : _profiledata.fixes)
-                {
-                    desc = regex_replace(desc, regex{fix}, "");
-                }
-                desc = remove_html(desc);
-                if (_profiledata.add_hashtags)
-                {
-                    desc = add_hashtags(desc);
-                }
-                return desc;
-            }();
-            // clang-format on
-            item.guid = move(guid);
-            item.link = rssitem.get<string>("link");
-            item.title = mastodonpp::unescape_html(title);
-            new_items.push_front(item);
+void Document::select_shared()
+{
+    if (_feed->error)
+    {
+        std::rethrow_exception(_feed->error);
+    }
 
-            BOOST_LOG_TRIVIAL(debug) << "Found GUID: " << item.guid;
+    if (_profiledata.feedurl != _feed->feedurl)
+    { // Permanently redirected.
+        _profiledata.feedurl = _feed->feedurl;
+        _cfg.write();
+    }
+    _poll_hint = _feed->poll_hint;
+    if (_feed->not_modified)
+    {
+        _not_modified = true;
+        return;
+    }
+    _profiledata.etag = _feed->etag;
+    _profiledata.last_modified = _feed->last_modified;
 
-            if (_profiledata.guids.empty() && !_profiledata.keep_looking)
-            {
-                BOOST_LOG_TRIVIAL(debug) << "This is the first run.";
-                break;
-            }
+    _counter = 0;
+    _arrived = false;
+    for (const auto &shared_item : _feed->items)
+    {
+        RSSParser::item rssitem{shared_item};
+        if (!select_item(rssitem))
+        {
+            break;
         }
     }
 }
 
-string Document::remove_html(string html)
+bool Document::select_item(RSSParser::item &rssitem)
 {
-    html = mastodonpp::unescape_html(html); // Decode HTML entities.
+    if (_counter == _profiledata.guids.capacity())
+    {
+        BOOST_LOG_TRIVIAL(debug)
+            << "Maximum number of items reached. Stopped parsing.";
+        return false;
+    }
+    ++_counter;
 
-    html = regex_replace(html, regex{"<p>"}, "\n\n");
-    html = regex_replace(html, regex{"<br>"}, "\n");
+    string guid{rssitem.guid.value_or("")};
+    if (guid.empty()) // We hope either <guid> or <link> are present.
+    {
+        guid = get_element(rssitem.link, "link");
+    }
+    if (_profiledata.guids.contains(guid))
+    {
+        BOOST_LOG_TRIVIAL(debug) << "Found already posted GUID: " << guid;
+        if (_profiledata.keep_looking)
+        {
+            return true;
+        }
+
+        BOOST_LOG_TRIVIAL(debug) << "Stopped parsing.";
+        return false;
+    }
+    _arrived = true;
 
-    const list re_list{regex{R"(<!\[CDATA\[)"},      // CDATA beginning.
-                       regex{R"(\]\]>)"},            // CDATA end.
-                       regex{"<[^>]+>"},             // HTML tags.
-                       regex{R"(\r)"},               // Carriage return.
-                       regex{"\\n[ \\t\u00a0]+\\n"}, // Space between newlines.
-                       regex{R"(^\n+)"}};            // Newlines at beginning.
-    for (const regex &re : re_list)
+    const string &title{get_element(rssitem.title, "title")};
+    if (_cfg.compiled.skip(title))
     {
-        html = regex_replace(html, re, "");
+        BOOST_LOG_TRIVIAL(debug) << "Skipped GUID: " << guid;
+        return true;
     }
 
-    // Remove excess newlines.
-    html = regex_replace(html, regex{R"(\n{3,})"}, "\n\n");
-    // Replace single newlines with spaces (?<= is lookbehind, ?= is lookahead).
-    html = regex_replace(html, regex{R"((?<=[^\n])\n(?=[^\n]))"}, " ");
+    get_element(rssitem.description, "description");
+    get_element(rssitem.link, "link");
+    rssitem.guid = move(guid);
+    BOOST_LOG_TRIVIAL(debug) << "Found GUID: " << *rssitem.guid;
+    _selected.push_front(move(rssitem));
 
+    if (_profiledata.guids.empty() && !_profiledata.keep_looking)
+    {
+        BOOST_LOG_TRIVIAL(debug) << "This is the first run.";
+        return false;
+    }
+
+    return true;
+}
+
+Item Document::make_item(RSSParser::item &rssitem,
+                         const WatchwordMatcher &watchwords) const
+{
+    Item item;
+    item.description = [&]
+    // clang-format off
+    {
+        string desc{_cfg.compiled.apply_fixes(move(*rssitem.description))};
+        desc = remove_html(desc);
+        if (_profiledata.add_hashtags)
+        {
+            desc = watchwords.add_hashtags(desc);
+        }
+        return desc;
+    }();
+    // clang-format on
+    item.guid = move(*rssitem.guid);
+    item.link = move(*rssitem.link);
+    item.title = mastodonpp::unescape_html(*rssitem.title);
+
+    return item;
+}
+
+string Document::remove_html(const string &html)
+{
+    string text{html_to_text(html)};
     BOOST_LOG_TRIVIAL(debug) << "Converted HTML to text.";
 
-    return html;
+    return text;
 }
 
 string Document::extract_location(const curl_wrapper::answer &answer)
@@ -273,24 +499,16 @@ string Document::extract_location(const curl_wrapper::answer &answer)
     return location;
 }
 
-string Document::add_hashtags(const string &text)
+list<string> Document::parse_watchwords(const Config &cfg)
 {
-    string out{text};
-    for (const auto &tag : _watchwords)
+    list<string> watchwords;
+    if (!cfg.profiledata.add_hashtags)
     {
-        regex re_tag("([[:space:]\u200b]|^)(" + tag
-                         + ")([[:space:]\u200b[:punct:]]|$)",
-                     regex::icase);
-        out = regex_replace(out, re_tag, "$1#$2$3", boost::format_first_only);
+        return watchwords;
     }
 
-    return out;
-}
-
-void Document::parse_watchwords()
-{
     Json::Value json;
-    const auto filepath = _cfg.get_config_dir() /= "watchwords.json";
+    const auto filepath = Config::get_config_dir() /= "watchwords.json";
     ifstream file(filepath.c_str());
     if (file.good())
     {
@@ -301,20 +519,108 @@ void Document::parse_watchwords()
     }
     else
     {
-        BOOST_LOG_TRIVIAL(warning)
-            << "File Not found: "
-            << (_cfg.get_config_dir() /= "watchwords.json").string();
-        return;
+        BOOST_LOG_TRIVIAL(warning) << "File Not found: " << filepath.string();
+        return watchwords;
     }
 
-    const auto &tags_profile = json[_cfg.profile]["tags"];
+    const auto &tags_profile = json[cfg.profile]["tags"];
     const auto &tags_global = json["global"]["tags"];
     transform(tags_profile.begin(), tags_profile.end(),
-              std::back_inserter(_watchwords),
+              std::back_inserter(watchwords),
               [](const Json::Value &value) { return value.asString(); });
     transform(tags_global.begin(), tags_global.end(),
-              std::back_inserter(_watchwords),
+              std::back_inserter(watchwords),
               [](const Json::Value &value) { return value.asString(); });
+
+    return watchwords;
+}
+
+string Document::normalize_url(const string_view url)
+{
+    string normalized{url.substr(0, url.find('#'))};
+    const size_t pos_scheme{normalized.find("://")};
+    if (pos_scheme == string::npos)
+    {
+        return normalized;
+    }
+
+    size_t pos_path{normalized.find_first_of("/?", pos_scheme + 3)};
+    if (pos_path == string::npos || normalized[pos_path] == '?')
+    {
+        pos_path = (pos_path == string::npos) ? normalized.size() : pos_path;
+        normalized.insert(pos_path, 1, '/');
+    }
+    transform(normalized.begin(),
+              normalized.begin() + static_cast<std::ptrdiff_t>(pos_path),
+              normalized.begin(),
+              [](const unsigned char c)
+              { return static_cast<char>(std::tolower(c)); });
+
+    // Remove default ports.
+    const string_view authority{string_view(normalized).substr(0, pos_path)};
+    const auto ends_with{[&authority](const string_view suffix)
+    {
+        return authority.size() > suffix.size()
+               && authority.substr(authority.size() - suffix.size()) == suffix;
+    }};
+    for (const auto &[scheme, port] : {std::pair{"http://", ":80"},
+                                       std::pair{"https://", ":443"}})
+    {
+        if (authority.substr(0, string_view(scheme).size()) == scheme
+            && ends_with(port))
+        {
+            normalized.erase(pos_path - string_view(port).size(),
+                             string_view(port).size());
+            break;
+        }
+    }
+
+    return normalized;
+}
+
+WatchwordMatcher Document::load_watchwords(const Config &cfg)
+{
+    if (!cfg.profiledata.add_hashtags)
+    {
+        return WatchwordMatcher{};
+    }
+
+    // The hash catches edits that keep the size and the modification time.
+    const auto filepath = Config::get_config_dir() /= "watchwords.json";
+    ifstream file(filepath.c_str(), std::ios::binary);
+    if (!file.good())
+    {
+        return WatchwordMatcher{parse_watchwords(cfg)};
+    }
+    stringstream content;
+    content << file.rdbuf();
+    const string data{content.str()};
+    const WatchwordMatcher::source from{data.size(), fnv1a_64(data)};
+
+    const auto cachepath = Config::get_config_dir() /=
+        "watchwords-" + cfg.profile + ".cache";
+    auto cached{WatchwordMatcher::load(cachepath, from)};
+    if (cached)
+    {
+        BOOST_LOG_TRIVIAL(debug) << "Loaded " << cachepath;
+        return std::move(*cached);
+    }
+
+    WatchwordMatcher matcher{parse_watchwords(cfg)};
+    if (cfg.dry_run())
+    {
+        return matcher;
+    }
+    if (matcher.save(cachepath, from))
+    {
+        BOOST_LOG_TRIVIAL(debug) << "Wrote " << cachepath;
+    }
+    else
+    {
+        BOOST_LOG_TRIVIAL(warning) << "Could not write " << cachepath;
+    }
+
+    return matcher;
 }
 
 } // namespace mastorss
@@ -18,32 +18,46 @@
 #define MASTORSS_DOCUMENT_HPP
 
 #include "config.hpp"
+#include "curl_multi_wrapper.hpp"
+#include "curl_pool.hpp"
 #include "curl_wrapper.hpp"
+#include "item.hpp"
+#include "rss_parser.hpp"
+#include "watchword_matcher.hpp"
 
-#include <boost/property_tree/ptree.hpp>
-
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <list>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace mastorss
 {
-namespace pt = boost::property_tree;
 using std::list;
+using std::optional;
 using std::string;
+using std::string_view;
+using std::vector;
 
 /*!
- *  @brief  An Item of a feed.
+ *  @brief  A feed that was downloaded once for several profiles.
  *
- *  @since  0.10.0
+ *  @since  0.14.0
  */
-struct Item
+struct SharedFeed
 {
-    string description;
-    string guid;
-    string link;
-    string title;
-
-    friend bool operator!=(const Item &a, const Item &b);
+    std::exception_ptr error; //!< Error during the download or parsing.
+    bool not_modified{false};
+    vector<RSSParser::item> items; //!< In the order of the feed.
+    string feedurl;                //!< After permanent redirects.
+    string etag;
+    string last_modified;
+    std::chrono::seconds poll_hint{0};
 };
 
 /*!
@@ -54,21 +68,142 @@ struct Item
 class Document
 {
 public:
-    explicit Document(Config &cfg);
-    Document(const Document &other) = default;
+    /*!
+     *  @brief  Download the feed.
+     *
+     *  The feed is parsed while it is downloaded. The transfer is stopped as
+     *  soon as an already posted item or the maximum number of items is
+     *  reached, the rest of the feed is not downloaded.
+     *
+     *  @param  cfg  The configuration of the profile.
+     *  @param  pool Pool to lease the handle from. The handles in a pool share
+     *               connections, DNS answers and TLS sessions.
+     *
+     *  @since  0.14.0
+     */
+    Document(Config &cfg, curl_wrapper::CURLPool &pool);
+
+    /*!
+     *  @brief  Queue the download of the feed.
+     *
+     *  The feed is downloaded together with the other requests in `multi`.
+     *  Call parse() after curl_wrapper::CURLMultiWrapper::perform() returned.
+     *  Errors during the download are thrown by parse().
+     *
+     *  @since  0.14.0
+     */
+    Document(Config &cfg, curl_wrapper::CURLPool &pool,
+             curl_wrapper::CURLMultiWrapper &multi);
+
+    /*!
+     *  @brief  Queue the download of a feed for several profiles.
+     *
+     *  Like the constructor above, but the download is not stopped at posted
+     *  items. Up to `max_items` items are kept, to be shared with the other
+     *  profiles by share(). Only send the validators of `cfg` if the other
+     *  profiles have the same.
+     *
+     *  @since  0.14.0
+     */
+    Document(Config &cfg, curl_wrapper::CURLPool &pool,
+             curl_wrapper::CURLMultiWrapper &multi, size_t max_items);
+
+    /*!
+     *  @brief  Use a feed that was downloaded for another profile.
+     *
+     *  parse() selects the items for this profile from `feed` and takes over
+     *  its validators and location.
+     *
+     *  @since  0.14.0
+     */
+    Document(Config &cfg, std::shared_ptr<const SharedFeed> feed);
+    Document(const Document &other) = delete;
     Document &operator=(const Document &other) = delete;
-    Document(Document &&other) = default;
+    Document(Document &&other) = delete;
     Document &operator=(Document &&other) = delete;
 
     list<Item> new_items;
 
-    void parse();
+    /*!
+     *  @brief  Turn the new items of the downloaded feed into #new_items.
+     *
+     *  Does nothing if the feed was not modified since the last download.
+     *  Throws errors that occurred during the download. Plans the next check
+     *  of the feed, see plan_next_check().
+     *
+     *  @param  watchwords Words to turn into hashtags, see load_watchwords().
+     *
+     *  @since  0.14.0
+     */
+    void parse(const WatchwordMatcher &watchwords);
+
+    /*!
+     *  @brief  Returns the downloaded feed for the other profiles.
+     *
+     *  Only for documents constructed with `max_items`. Call it after
+     *  curl_wrapper::CURLMultiWrapper::perform() returned. Errors are passed
+     *  on in SharedFeed::error instead of being thrown.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] std::shared_ptr<const SharedFeed> share();
+
+    /*!
+     *  @brief  Returns true if the server answered with 304 Not Modified.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] inline bool not_modified() const
+    {
+        return _not_modified;
+    }
+
+    /*!
+     *  @brief  Read the watchwords for the profile from `watchwords.json`.
+     *
+     *  Returns an empty list if hashtags are disabled for the profile.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] static list<string> parse_watchwords(const Config &cfg);
+
+    /*!
+     *  @brief  Load the watchword automaton for the profile.
+     *
+     *  The automaton is cached in `watchwords-<profile>.cache` and only built
+     *  again if the size or the hash of `watchwords.json` changed. The cache
+     *  is not written in a dry run. Returns an empty matcher if hashtags are
+     *  disabled for the profile.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] static WatchwordMatcher load_watchwords(const Config &cfg);
+
+    /*!
+     *  @brief  Returns the URL in a form that is equal for equal feeds.
+     *
+     *  Scheme and host are lowercased, default ports and the fragment are
+     *  removed and an empty path becomes `/`.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] static string normalize_url(string_view url);
 
 private:
     Config &_cfg;
     ProfileData &_profiledata;
-    string _raw_doc;
-    list<string> _watchwords;
+    curl_wrapper::CURLPool::lease_type _curl;
+    curl_wrapper::CURLMultiWrapper *_multi{nullptr};
+    std::exception_ptr _error;
+    bool _not_modified{false};
+    bool _arrived{false}; //!< The feed has items that were not posted.
+    std::chrono::seconds _poll_hint{0};
+    optional<RSSParser> _parser;
+    list<RSSParser::item> _selected;
+    size_t _counter{0};
+    std::shared_ptr<SharedFeed> _shared; //!< Being downloaded.
+    size_t _max_shared{0};
+    std::shared_ptr<const SharedFeed> _feed; //!< Downloaded.
 
     void download();
     /*!
@@ -83,12 +218,40 @@ private:
      *  @since  0.10.0
      */
     void download(const string &uri, bool temp_redirect = false);
-    void parse_rss(const pt::ptree &tree);
-    [[nodiscard]] static string remove_html(string html);
+    void handle_answer(const curl_wrapper::answer &answer, bool temp_redirect);
+    /*!
+     *  @brief  Feed a chunk of the body to the parser.
+     *
+     *  @return `false` if the transfer should be stopped.
+     *
+     *  @since  0.14.0
+     */
+    bool feed(std::uint16_t status, string_view data);
+    /*!
+     *  @brief  Throw errors of the download and finish parsing.
+     *
+     *  @since  0.14.0
+     */
+    void finish_download();
+    /*!
+     *  @brief  Select the items of the shared feed for this profile.
+     *
+     *  @since  0.14.0
+     */
+    void select_shared();
+    /*!
+     *  @brief  Remember the item, if it is new and not skipped.
+     *
+     *  @return `false` if no more items should be parsed.
+     *
+     *  @since  0.14.0
+     */
+    bool select_item(RSSParser::item &rssitem);
+    [[nodiscard]] Item make_item(RSSParser::item &rssitem,
+                                 const WatchwordMatcher &watchwords) const;
+    [[nodiscard]] static string remove_html(const string &html);
     [[nodiscard]] static string
     extract_location(const curl_wrapper::answer &answer);
-    string add_hashtags(const string &text);
-    void parse_watchwords();
 };
 } // namespace mastorss
 
@@ -53,6 +53,15 @@ const char *FileException::what() const noexcept
     return _message.c_str();
 }
 
+ConfigException::ConfigException(string message)
+    : _message{move(message)}
+{}
+
+const char *ConfigException::what() const noexcept
+{
+    return _message.c_str();
+}
+
 ParseException::ParseException(string message)
     : _message{move(message)}
 {}
@@ -61,6 +61,18 @@ private:
     const string _message;
 };
 
+class ConfigException : public exception
+{
+public:
+    explicit ConfigException(string message);
+
+    [[nodiscard]]
+    const char *what() const noexcept override;
+
+private:
+    const string _message;
+};
+
 class ParseException : public exception
 {
 public:
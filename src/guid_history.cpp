@@ -0,0 +1,268 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "guid_history.hpp"
+
+#include "exceptions.hpp"
+#include "util.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace mastorss
+{
+namespace bip = boost::interprocess;
+using std::move;
+
+namespace
+{
+constexpr char magic[]{"MRSSGUID"}; // NOLINT(modernize-avoid-c-arrays)
+constexpr uint32_t version{1};
+constexpr size_t npos{static_cast<size_t>(-1)};
+} // namespace
+
+GUIDHistory::GUIDHistory(const size_t capacity)
+{
+    const size_t clamped{std::clamp(capacity, size_t{1}, max_capacity)};
+    _memory.resize(words(clamped));
+    init(_memory.data(), clamped);
+    attach(_memory.data());
+}
+
+void GUIDHistory::open(const fs::path &path, const bool read_only)
+{
+    const size_t wanted_capacity{capacity()};
+
+    if (!fs::exists(path))
+    {
+        if (read_only)
+        {
+            return;
+        }
+        std::ofstream file{path.c_str(), std::ios::binary};
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        file.write(reinterpret_cast<const char *>(_memory.data()),
+                   static_cast<std::streamsize>(_memory.size()
+                                                * sizeof(uint64_t)));
+        if (!file.good())
+        {
+            throw FileException{"Could not write " + path.string() + "."};
+        }
+        BOOST_LOG_TRIVIAL(debug) << "Created GUID state file " << path;
+    }
+
+    try
+    {
+        const bip::mode_t mode{read_only ? bip::copy_on_write
+                                         : bip::read_write};
+        const bip::file_mapping file{path.c_str(), read_only ? bip::read_only
+                                                            : bip::read_write};
+        bip::mapped_region region{file, mode};
+
+        // Validate before using anything from the file.
+        const size_t file_size{region.get_size()};
+        const auto *hdr{static_cast<const header *>(region.get_address())};
+        if (file_size < sizeof(header)
+            || std::memcmp(hdr->magic, magic, sizeof(hdr->magic)) != 0
+            || hdr->version != version || hdr->capacity == 0
+            || hdr->capacity > max_capacity
+            || hdr->table_size != table_size(hdr->capacity)
+            || file_size != words(hdr->capacity) * sizeof(uint64_t)
+            || hdr->size > hdr->capacity || hdr->oldest >= hdr->capacity)
+        {
+            throw FileException{path.string()
+                                + " is not a valid GUID state file."};
+        }
+
+        _region = move(region);
+        attach(_region.get_address());
+        _memory = {};
+    }
+    catch (const bip::interprocess_exception &e)
+    {
+        throw FileException{"Could not open " + path.string() + ": "
+                            + e.what()};
+    }
+
+    if (capacity() != wanted_capacity)
+    {
+        BOOST_LOG_TRIVIAL(debug) << "Resizing GUID state file to "
+                                 << wanted_capacity << " entries.";
+        GUIDHistory resized{wanted_capacity};
+        copy_to(resized);
+        *this = move(resized);
+        if (!read_only)
+        {
+            const fs::path tmp{path.string() + ".new"};
+            fs::remove(tmp);
+            open(tmp);
+            fs::rename(tmp, path);
+        }
+    }
+}
+
+void GUIDHistory::flush()
+{
+    if (_region.get_address() != nullptr)
+    {
+        _region.flush();
+    }
+}
+
+bool GUIDHistory::contains(const string_view guid) const
+{
+    return find(fingerprint(guid)) != npos;
+}
+
+void GUIDHistory::push(const string_view guid)
+{
+    const uint64_t fp{fingerprint(guid)};
+    if (find(fp) != npos)
+    {
+        return;
+    }
+
+    if (_header->size < _header->capacity)
+    {
+        _ring[(_header->oldest + _header->size) % _header->capacity] = fp;
+        ++_header->size;
+    }
+    else
+    {
+        erase(_ring[_header->oldest]);
+        _ring[_header->oldest] = fp;
+        _header->oldest = (_header->oldest + 1) % _header->capacity;
+    }
+    insert(fp);
+}
+
+void GUIDHistory::set_capacity(const size_t capacity)
+{
+    GUIDHistory resized{capacity};
+    copy_to(resized);
+    *this = move(resized);
+}
+
+size_t GUIDHistory::words(const size_t capacity)
+{
+    return sizeof(header) / sizeof(uint64_t) + capacity + table_size(capacity);
+}
+
+uint32_t GUIDHistory::table_size(const size_t capacity)
+{
+    // At most half full, so probe sequences stay short.
+    uint32_t size{1};
+    while (size < capacity * 2)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+uint64_t GUIDHistory::fingerprint(const string_view guid)
+{
+    const uint64_t hash{fnv1a_64(guid)};
+    return (hash == 0) ? 1 : hash; // 0 marks empty slots.
+}
+
+void GUIDHistory::attach(void *data)
+{
+    _header = static_cast<header *>(data);
+    _ring = static_cast<uint64_t *>(data) + sizeof(header) / sizeof(uint64_t);
+    _table = _ring + _header->capacity;
+}
+
+void GUIDHistory::init(void *data, const size_t capacity)
+{
+    std::memset(data, 0, words(capacity) * sizeof(uint64_t));
+    auto *hdr{static_cast<header *>(data)};
+    std::memcpy(hdr->magic, magic, sizeof(hdr->magic));
+    hdr->version = version;
+    hdr->capacity = static_cast<uint32_t>(capacity);
+    hdr->table_size = table_size(capacity);
+}
+
+void GUIDHistory::copy_to(GUIDHistory &other) const
+{
+    // Skip the oldest GUIDs that don't fit.
+    const size_t skip{(size() > other.capacity()) ? size() - other.capacity()
+                                                  : 0};
+    for (size_t pos{skip}; pos < size(); ++pos)
+    {
+        const uint64_t fp{_ring[(_header->oldest + pos) % capacity()]};
+        if (other.find(fp) == npos)
+        {
+            other._ring[other._header->size++] = fp;
+            other.insert(fp);
+        }
+    }
+}
+
+void GUIDHistory::insert(const uint64_t fp)
+{
+    const size_t mask{_header->table_size - 1};
+    size_t pos{fp & mask};
+    while (_table[pos] != 0)
+    {
+        pos = (pos + 1) & mask;
+    }
+    _table[pos] = fp;
+}
+
+size_t GUIDHistory::find(const uint64_t fp) const
+{
+    const size_t mask{_header->table_size - 1};
+    for (size_t pos{fp & mask}; _table[pos] != 0; pos = (pos + 1) & mask)
+    {
+        if (_table[pos] == fp)
+        {
+            return pos;
+        }
+    }
+    return npos;
+}
+
+void GUIDHistory::erase(const uint64_t fp)
+{
+    size_t hole{find(fp)};
+    if (hole == npos)
+    {
+        return;
+    }
+
+    // Move following entries back so no probe sequence is interrupted.
+    const size_t mask{_header->table_size - 1};
+    for (size_t pos{(hole + 1) & mask}; _table[pos] != 0;
+         pos = (pos + 1) & mask)
+    {
+        const size_t home{_table[pos] & mask};
+        // Entries whose home is cyclically in (hole, pos] stay.
+        const bool stays{(hole < pos) ? (home > hole && home <= pos)
+                                      : (home > hole || home <= pos)};
+        if (!stays)
+        {
+            _table[hole] = _table[pos];
+            hole = pos;
+        }
+    }
+    _table[hole] = 0;
+}
+} // namespace mastorss
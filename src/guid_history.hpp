@@ -0,0 +1,169 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_GUID_HISTORY_HPP
+#define MASTORSS_GUID_HISTORY_HPP
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace mastorss
+{
+namespace fs = boost::filesystem;
+using std::string_view;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+/*!
+ *  @brief  The GUIDs of the last posted items.
+ *
+ *  Only 64-bit fingerprints of the GUIDs are stored, in a ring buffer with a
+ *  hash table as index: Looking up a GUID takes constant time and when the
+ *  history is full, the oldest GUID is forgotten.
+ *
+ *  The history is kept in memory until open() is called, after that it lives
+ *  in a memory-mapped file and every change is made in place. The file has the
+ *  byte order of the machine:
+ *
+ *  - Header: The magic bytes `MRSSGUID`, the version, the capacity, the size of
+ *    the hash table, the number of GUIDs and the position of the oldest GUID
+ *    in the ring, as 32-bit unsigned integers, and 4 bytes of padding.
+ *  - The ring: `capacity` fingerprints.
+ *  - The hash table: `table size` fingerprints (a power of 2), with linear
+ *    probing. 0 marks an empty slot.
+ *
+ *  @since  0.14.0
+ */
+class GUIDHistory
+{
+public:
+    //! Number of GUIDs that are remembered by default. @since  0.14.0
+    constexpr static size_t default_capacity{100};
+    //! Maximum number of GUIDs that can be remembered. @since  0.14.0
+    constexpr static size_t max_capacity{100000};
+
+    /*!
+     *  @brief  Construct an empty history in memory.
+     *
+     *  @param  capacity Number of GUIDs to remember, clamped to
+     *                   1–#max_capacity.
+     *
+     *  @since  0.14.0
+     */
+    explicit GUIDHistory(size_t capacity = default_capacity);
+    ~GUIDHistory() = default;
+    GUIDHistory(const GUIDHistory &other) = delete;
+    GUIDHistory &operator=(const GUIDHistory &other) = delete;
+    GUIDHistory(GUIDHistory &&other) noexcept = default;
+    GUIDHistory &operator=(GUIDHistory &&other) noexcept = default;
+
+    /*!
+     *  @brief  Use the state file at `path`.
+     *
+     *  If the file doesn't exist, it is created with the GUIDs that are
+     *  already in the history. If the capacity of the file is different, it
+     *  is resized, keeping the newest GUIDs.
+     *
+     *  Throws FileException if the file is not a GUID state file.
+     *
+     *  @param  path      The state file.
+     *  @param  read_only Don't change the file, changes are kept in memory.
+     *
+     *  @since  0.14.0
+     */
+    void open(const fs::path &path, bool read_only = false);
+
+    //! Write changes to disk. @since  0.14.0
+    void flush();
+
+    //! Returns `true` if the GUID is in the history. @since  0.14.0
+    [[nodiscard]] bool contains(string_view guid) const;
+
+    /*!
+     *  @brief  Add a GUID, forgetting the oldest if the history is full.
+     *
+     *  Does nothing if the GUID is already in the history.
+     *
+     *  @since  0.14.0
+     */
+    void push(string_view guid);
+
+    /*!
+     *  @brief  Change the number of GUIDs to remember.
+     *
+     *  If the history shrinks, the oldest GUIDs are forgotten. Must be called
+     *  before open().
+     *
+     *  @since  0.14.0
+     */
+    void set_capacity(size_t capacity);
+
+    [[nodiscard]] inline size_t size() const
+    {
+        return _header->size;
+    }
+
+    [[nodiscard]] inline bool empty() const
+    {
+        return _header->size == 0;
+    }
+
+    [[nodiscard]] inline size_t capacity() const
+    {
+        return _header->capacity;
+    }
+
+private:
+    struct header
+    {
+        char magic[8]; // NOLINT(modernize-avoid-c-arrays)
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t table_size;
+        uint32_t size;
+        uint32_t oldest;
+        uint32_t padding;
+    };
+
+    vector<uint64_t> _memory;
+    boost::interprocess::mapped_region _region;
+    header *_header{nullptr};
+    uint64_t *_ring{nullptr};
+    uint64_t *_table{nullptr};
+
+    //! Number of 64-bit words needed for the capacity. @since  0.14.0
+    [[nodiscard]] static size_t words(size_t capacity);
+    [[nodiscard]] static uint32_t table_size(size_t capacity);
+    [[nodiscard]] static uint64_t fingerprint(string_view guid);
+    //! Set the pointers into the data at `data`. @since  0.14.0
+    void attach(void *data);
+    //! Create an empty history in `data`. @since  0.14.0
+    static void init(void *data, size_t capacity);
+    //! Copy the GUIDs to `other`, oldest first. @since  0.14.0
+    void copy_to(GUIDHistory &other) const;
+    void insert(uint64_t fp);
+    [[nodiscard]] size_t find(uint64_t fp) const;
+    void erase(uint64_t fp);
+};
+} // namespace mastorss
+
+#endif // MASTORSS_GUID_HISTORY_HPP
@@ -0,0 +1,40 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_HTML_ENTITIES_HPP
+#define MASTORSS_HTML_ENTITIES_HPP
+
+#include <optional>
+#include <string_view>
+
+namespace mastorss
+{
+using std::optional;
+using std::string_view;
+
+/*!
+ *  @brief  Look up a named HTML character reference.
+ *
+ *  @param  name The name, without `&` and `;`.
+ *
+ *  @return The UTF-8 encoded characters or an empty optional.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] optional<string_view> find_html_entity(string_view name);
+} // namespace mastorss
+
+#endif // MASTORSS_HTML_ENTITIES_HPP
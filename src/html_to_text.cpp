@@ -0,0 +1,428 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "html_to_text.hpp"
+
+#include "html_entities.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mastorss
+{
+namespace
+{
+constexpr size_t npos{string_view::npos};
+
+// A character of the input after decoding entities.
+struct unit
+{
+    std::array<char, 8> bytes{};
+    size_t size{0};
+    size_t next{0}; // Position of the next unit in the input.
+
+    [[nodiscard]] bool is(const char c) const
+    {
+        return size == 1 && bytes[0] == c;
+    }
+};
+
+class Converter
+{
+public:
+    explicit Converter(const string_view html)
+        : _in{html}
+    {
+        _out.reserve(html.size());
+    }
+
+    string convert()
+    {
+        size_t pos{0};
+        while (pos < _in.size())
+        {
+            const unit current{decode(pos)};
+            size_t end{0};
+            if (current.is('<'))
+            {
+                if (starts_with(pos, "<p>", end))
+                {
+                    line_break();
+                    line_break();
+                    pos = end;
+                    continue;
+                }
+                if (starts_with(pos, "<br>", end))
+                {
+                    line_break();
+                    pos = end;
+                    continue;
+                }
+                if (starts_with(pos, "<![CDATA[", end))
+                {
+                    pos = end;
+                    continue;
+                }
+                end = tag_end(current.next);
+                if (end != npos)
+                {
+                    pos = end;
+                    continue;
+                }
+            }
+            else if (current.is(']') && starts_with(pos, "]]>", end))
+            {
+                pos = end;
+                continue;
+            }
+
+            for (size_t i{0}; i < current.size; ++i)
+            {
+                put(current.bytes[i]);
+            }
+            pos = current.next;
+        }
+        finish();
+
+        return std::move(_out);
+    }
+
+private:
+    // States of the search for lines with only whitespace.
+    enum class line
+    {
+        text,      // Not in a line break.
+        broken,    // After a line break.
+        whitespace // After a line break and whitespace.
+    };
+
+    const string_view _in;
+    string _out;
+    line _line{line::text};
+    string _whitespace;
+    bool _at_start{true};
+    bool _line_break{false};
+    bool _no_tag_end{false};
+
+    // Decode the character or entity at pos.
+    [[nodiscard]] unit decode(const size_t pos) const
+    {
+        unit ret;
+        ret.bytes[0] = _in[pos];
+        ret.size = 1;
+        ret.next = pos + 1;
+        if (_in[pos] != '&')
+        {
+            return ret;
+        }
+
+        constexpr size_t max_name{32};
+        size_t end{pos + 1};
+        while (end < _in.size() && end - pos <= max_name
+               && (isalnum(_in[end]) || (end == pos + 1 && _in[end] == '#')))
+        {
+            ++end;
+        }
+        if (end >= _in.size() || _in[end] != ';' || end == pos + 1)
+        {
+            return ret;
+        }
+
+        const string_view name{_in.substr(pos + 1, end - pos - 1)};
+        if (name[0] == '#')
+        {
+            return decode_number(name.substr(1), end + 1, ret);
+        }
+        const auto value{find_html_entity(name)};
+        if (value)
+        {
+            value->copy(ret.bytes.data(), value->size());
+            ret.size = value->size();
+            ret.next = end + 1;
+        }
+        return ret;
+    }
+
+    [[nodiscard]] static unit decode_number(const string_view number,
+                                            const size_t next, unit ret)
+    {
+        const bool hex{!number.empty()
+                       && (number[0] == 'x' || number[0] == 'X')};
+        const string_view digits{number.substr(hex ? 1 : 0)};
+        if (digits.empty() || digits.size() > 8)
+        {
+            return ret;
+        }
+
+        std::uint32_t cp{0};
+        for (const char c : digits)
+        {
+            std::uint32_t digit{0};
+            if (c >= '0' && c <= '9')
+            {
+                digit = static_cast<std::uint32_t>(c - '0');
+            }
+            else if (hex && c >= 'a' && c <= 'f')
+            {
+                digit = static_cast<std::uint32_t>(c - 'a' + 10);
+            }
+            else if (hex && c >= 'A' && c <= 'F')
+            {
+                digit = static_cast<std::uint32_t>(c - 'A' + 10);
+            }
+            else
+            {
+                return ret;
+            }
+            cp = cp * (hex ? 16U : 10U) + digit;
+        }
+        if (cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        {
+            return ret;
+        }
+
+        // Encode as UTF-8.
+        auto &b{ret.bytes};
+        if (cp < 0x80)
+        {
+            b[0] = static_cast<char>(cp);
+            ret.size = 1;
+        }
+        else if (cp < 0x800)
+        {
+            b[0] = static_cast<char>(0xC0 | (cp >> 6));
+            b[1] = static_cast<char>(0x80 | (cp & 0x3F));
+            ret.size = 2;
+        }
+        else if (cp < 0x10000)
+        {
+            b[0] = static_cast<char>(0xE0 | (cp >> 12));
+            b[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            b[2] = static_cast<char>(0x80 | (cp & 0x3F));
+            ret.size = 3;
+        }
+        else
+        {
+            b[0] = static_cast<char>(0xF0 | (cp >> 18));
+            b[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            b[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            b[3] = static_cast<char>(0x80 | (cp & 0x3F));
+            ret.size = 4;
+        }
+        ret.next = next;
+        return ret;
+    }
+
+    [[nodiscard]] static bool isalnum(const char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')
+               || (c >= 'A' && c <= 'Z');
+    }
+
+    // Compare the decoded input at pos with literal, set end if it matches.
+    [[nodiscard]] bool starts_with(size_t pos, const string_view literal,
+                                   size_t &end) const
+    {
+        size_t matched{0};
+        while (matched < literal.size())
+        {
+            if (pos >= _in.size())
+            {
+                return false;
+            }
+            const unit current{decode(pos)};
+            if (current.size > literal.size() - matched
+                || literal.compare(matched, current.size, current.bytes.data(),
+                                   current.size)
+                       != 0)
+            {
+                return false;
+            }
+            matched += current.size;
+            pos = current.next;
+        }
+        end = pos;
+        return true;
+    }
+
+    // Returns the position after the tag that starts before pos, or npos.
+    [[nodiscard]] size_t tag_end(size_t pos)
+    {
+        if (_no_tag_end)
+        {
+            return npos;
+        }
+
+        // <p>, <br>, <![CDATA[ and ]]> are replaced before tags are removed.
+        size_t length{0};
+        while (pos < _in.size())
+        {
+            const unit current{decode(pos)};
+            size_t end{0};
+            if (current.is('>'))
+            {
+                return (length > 0) ? current.next : npos;
+            }
+            if (current.is('<'))
+            {
+                if (starts_with(pos, "<p>", end))
+                {
+                    length += 2;
+                    pos = end;
+                    continue;
+                }
+                if (starts_with(pos, "<br>", end))
+                {
+                    ++length;
+                    pos = end;
+                    continue;
+                }
+                if (starts_with(pos, "<![CDATA[", end))
+                {
+                    pos = end;
+                    continue;
+                }
+            }
+            else if (current.is(']') && starts_with(pos, "]]>", end))
+            {
+                pos = end;
+                continue;
+            }
+            length += current.size;
+            pos = current.next;
+        }
+
+        // No tag can end after this.
+        _no_tag_end = true;
+        return npos;
+    }
+
+    void line_break()
+    {
+        put('\n');
+    }
+
+    // Removes carriage returns and line breaks with only whitespace between.
+    void put(const char c)
+    {
+        const bool whitespace{c == ' ' || c == '\t' || c == '\xC2'
+                              || c == '\xA0'};
+        if (c == '\r')
+        {
+            return;
+        }
+
+        switch (_line)
+        {
+        case line::text:
+        {
+            if (c == '\n')
+            {
+                _line = line::broken;
+                return;
+            }
+            break;
+        }
+        case line::broken:
+        {
+            if (whitespace)
+            {
+                _whitespace.assign(1, c);
+                _line = line::whitespace;
+                return;
+            }
+            put_folded('\n');
+            if (c == '\n')
+            {
+                return;
+            }
+            _line = line::text;
+            break;
+        }
+        case line::whitespace:
+        {
+            if (whitespace)
+            {
+                _whitespace += c;
+                return;
+            }
+            _line = line::text;
+            if (c == '\n')
+            {
+                return; // Drop the whole line.
+            }
+            put_folded('\n');
+            for (const char ws : _whitespace)
+            {
+                put_folded(ws);
+            }
+            break;
+        }
+        }
+
+        put_folded(c);
+    }
+
+    // Removes line breaks at the start of the text or after a form feed and
+    // turns the others into spaces.
+    void put_folded(const char c)
+    {
+        if (c == '\n')
+        {
+            if (!_at_start && (_line_break || _out.back() != '\f'))
+            {
+                _line_break = true;
+            }
+            return;
+        }
+        if (_line_break)
+        {
+            _out += ' ';
+            _line_break = false;
+        }
+        _out += c;
+        _at_start = false;
+    }
+
+    void finish()
+    {
+        if (_line == line::broken)
+        {
+            put_folded('\n');
+        }
+        else if (_line == line::whitespace)
+        {
+            put_folded('\n');
+            for (const char ws : _whitespace)
+            {
+                put_folded(ws);
+            }
+        }
+
+        if (_line_break)
+        {
+            _out += '\n';
+        }
+    }
+};
+} // namespace
+
+string html_to_text(const string_view html)
+{
+    return Converter{html}.convert();
+}
+} // namespace mastorss
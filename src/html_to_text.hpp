@@ -0,0 +1,41 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_HTML_TO_TEXT_HPP
+#define MASTORSS_HTML_TO_TEXT_HPP
+
+#include <string>
+#include <string_view>
+
+namespace mastorss
+{
+using std::string;
+using std::string_view;
+
+/*!
+ *  @brief  Convert HTML to plain text in one pass.
+ *
+ *  HTML entities are decoded, `<p>` and `<br>` become line breaks, tags,
+ *  CDATA markers and carriage returns are removed. Lines that only contain
+ *  whitespace are removed, leading line breaks are removed and the remaining
+ *  line breaks are replaced with spaces, except for one at the end.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] string html_to_text(string_view html);
+} // namespace mastorss
+
+#endif // MASTORSS_HTML_TO_TEXT_HPP
@@ -0,0 +1,45 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_ITEM_HPP
+#define MASTORSS_ITEM_HPP
+
+#include <string>
+
+namespace mastorss
+{
+using std::string;
+
+/*!
+ *  @brief  An Item of a feed.
+ *
+ *  @since  0.10.0
+ */
+struct Item
+{
+    string description;
+    string guid;
+    string link;
+    string title;
+
+    friend inline bool operator!=(const Item &a, const Item &b)
+    {
+        return a.guid != b.guid;
+    }
+};
+} // namespace mastorss
+
+#endif // MASTORSS_ITEM_HPP
@@ -14,23 +14,31 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "circuit_breaker.hpp"
 #include "config.hpp"
 #include "curl_wrapper.hpp"
+#include "daemon.hpp"
 #include "document.hpp"
 #include "exceptions.hpp"
 #include "mastoapi.hpp"
+#include "poll_schedule.hpp"
 #include "version.hpp"
 
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/utility/setup/console.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string_view>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace mastorss
@@ -38,9 +46,16 @@ namespace mastorss
 
 using std::cerr;
 using std::cout;
+using std::exception;
+using std::list;
+using std::max;
+using std::move;
+using std::optional;
 using std::runtime_error;
 using std::string_view;
 using std::chrono::seconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
 using std::this_thread::sleep_for;
 
 namespace error
@@ -51,12 +66,19 @@ constexpr int file = 3;
 // constexpr int mastodon = 4;
 constexpr int json = 5;
 constexpr int parse = 6;
+constexpr int config = 7;
+constexpr int skipped = 8;
 constexpr int unknown = 9;
+constexpr int not_due = 10;
 } // namespace error
 
 void print_version();
 void print_help(string_view command);
 int run(string_view profile_name, bool dry_run);
+void post_items(Config &cfg, MastoAPI &masto, const list<Item> &items,
+                optional<steady_clock::time_point> deadline, bool dry_run);
+int run_daemon(bool dry_run);
+int handle_exception();
 
 void print_version()
 {
@@ -73,6 +95,7 @@ void print_version()
 void print_help(const string_view command)
 {
     cerr << "Usage: " << command << " [--version|--help|--dry-run] <profile>\n"
+         << "       " << command << " [--dry-run] --daemon\n"
          << "See manpage for details.\n";
 }
 
@@ -83,33 +106,186 @@ int run(const string_view profile_name, const bool dry_run)
 
     try
     {
-        Config cfg{profilename.data()};
-        Document doc{cfg};
-        doc.parse();
+        Config cfg{profilename.data(), dry_run};
+        curl_wrapper::CURLPool pool;
+        if (cfg.profiledata.max_run_time > 0)
+        {
+            pool.set_deadline(steady_clock::now()
+                              + seconds{cfg.profiledata.max_run_time});
+        }
 
-        MastoAPI masto{cfg.profiledata};
-        if (!doc.new_items.empty())
+        // Finish an interrupted run before looking for new items.
+        list<Item> items{cfg.journal.pending()};
+        if (!items.empty())
+        {
+            BOOST_LOG_TRIVIAL(info)
+                << "Resuming " << items.size() << " items from the journal.";
+        }
+        else
         {
-            for (const auto &item : doc.new_items)
+            const auto remaining{
+                not_due(cfg.profiledata, system_clock::now())};
+            if (remaining && !dry_run)
+            {
+                BOOST_LOG_TRIVIAL(info) << "The feed is not due for another "
+                                        << remaining->count() << " seconds.";
+                return error::not_due;
+            }
+
+            CircuitBreaker breaker{dry_run ? fs::path{}
+                                           : Config::get_feedhosts_filename()};
+            const string host{
+                CircuitBreaker::host_of(cfg.profiledata.feedurl)};
+            if (const auto probe{breaker.blocked(host)})
+            {
+                const auto wait{std::chrono::duration_cast<seconds>(
+                    *probe - system_clock::now())};
+                BOOST_LOG_TRIVIAL(info)
+                    << "Skipping " << host << " after repeated failures, "
+                    << "next try in " << wait.count() << " seconds.";
+                return error::skipped;
+            }
+
+            std::unique_ptr<Document> doc;
+            try
             {
-                masto.post_item(item, dry_run);
-                if (item != *doc.new_items.rbegin())
-                { // Don't sleep if this is the last item.
-                    if (!dry_run)
-                    {
-                        sleep_for(seconds(cfg.profiledata.interval));
-                    }
-                    else
-                    {
-                        sleep_for(seconds(1));
-                    }
+                doc = std::make_unique<Document>(cfg, pool);
+            }
+            catch (const HTTPException &e)
+            {
+                if (CircuitBreaker::host_failure(e))
+                {
+                    breaker.failed(host);
                 }
+                cfg.save_state(); // Remember a Retry-After.
+                throw;
             }
-            if (!dry_run)
+            catch (const curl_wrapper::CURLException &e)
             {
-                cfg.write();
+                if (CircuitBreaker::host_failure(e))
+                {
+                    breaker.failed(host);
+                }
+                throw;
             }
+            breaker.succeeded(host);
+
+            doc->parse(Document::load_watchwords(cfg));
+            items = move(doc->new_items);
+            cfg.journal.append(items);
+        }
+
+        MastoAPI masto{cfg.profile, cfg.profiledata, cfg.compiled, pool};
+        try
+        {
+            post_items(cfg, masto, items, pool.deadline(), dry_run);
         }
+        catch (const exception &)
+        {
+            // Keep the GUIDs of the items that were posted.
+            cfg.save_state();
+            throw;
+        }
+        // Remember the GUIDs, the validators and the next check.
+        cfg.save_state();
+    }
+    catch (const exception &)
+    {
+        return handle_exception();
+    }
+
+    return 0;
+}
+
+void post_items(Config &cfg, MastoAPI &masto, const list<Item> &items,
+                const optional<steady_clock::time_point> deadline,
+                const bool dry_run)
+{
+    // Returns true and logs it if the deadline is reached within `ahead`.
+    const auto out_of_time{[&](const seconds ahead)
+    {
+        if (!deadline || steady_clock::now() + ahead < *deadline)
+        {
+            return false;
+        }
+        BOOST_LOG_TRIVIAL(info)
+            << "Run time limit reached, " << cfg.journal.pending().size()
+            << " items stay in the journal.";
+        return true;
+    }};
+
+    const seconds interval{cfg.profiledata.interval};
+    optional<system_clock::time_point> previous;
+    for (const auto &item : items)
+    {
+        if (out_of_time(seconds{0}))
+        {
+            break;
+        }
+        if (!dry_run)
+        {
+            if (const auto renewal{masto.reserve_post()})
+            {
+                const auto wait{std::chrono::duration_cast<seconds>(
+                    *renewal - system_clock::now())};
+                BOOST_LOG_TRIVIAL(info)
+                    << "Rate limit reached, " << cfg.journal.pending().size()
+                    << " items stay in the journal for " << wait.count()
+                    << " seconds.";
+                break;
+            }
+        }
+
+        if (cfg.profiledata.schedule)
+        { // Let the instance publish the items, the first right away.
+            const auto now{system_clock::now()};
+            optional<system_clock::time_point> scheduled_at;
+            if (previous)
+            { // Posting the previous items may have taken a while.
+                scheduled_at = max(*previous + interval,
+                                   now + MastoAPI::min_schedule_delay);
+            }
+            masto.post_item(item, dry_run, scheduled_at);
+            cfg.journal.commit(item.guid);
+            cfg.journal.sync();
+            previous = scheduled_at.value_or(now);
+            continue;
+        }
+
+        masto.post_item(item, dry_run);
+        cfg.journal.commit(item.guid);
+        cfg.journal.sync();
+        if (!dry_run && item != *items.rbegin())
+        { // Don't sleep if this is the last item.
+            if (out_of_time(interval))
+            {
+                break;
+            }
+            sleep_for(interval);
+        }
+    }
+}
+
+int run_daemon(const bool dry_run)
+{
+    try
+    {
+        Daemon daemon{dry_run};
+        daemon.run();
+    }
+    catch (const exception &)
+    {
+        return handle_exception();
+    }
+
+    return 0;
+}
+
+int handle_exception()
+{
+    try
+    {
+        throw;
     }
     catch (const FileException &e)
     {
@@ -141,6 +317,11 @@ int run(const string_view profile_name, const bool dry_run)
         cerr << e.what() << '\n';
         return error::parse;
     }
+    catch (const ConfigException &e)
+    {
+        cerr << e.what() << '\n';
+        return error::config;
+    }
     catch (const runtime_error &e)
     {
         cerr << e.what() << '\n';
@@ -188,8 +369,16 @@ int main(int argc, char *argv[])
         {
             print_help(args[0]);
         }
+        else if (args[1] == "--daemon")
+        {
+            return run_daemon(false);
+        }
         else if (args[1] == "--dry-run")
         {
+            if (args.size() > 2 && args[2] == "--daemon")
+            {
+                return run_daemon(true);
+            }
             return run(args[2], true);
         }
         else
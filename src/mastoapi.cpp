@@ -17,97 +17,207 @@
 #include "mastoapi.hpp"
 
 #include "exceptions.hpp"
+#include "poll_schedule.hpp"
+#include "text_length.hpp"
+#include "util.hpp"
 
 #include <boost/log/trivial.hpp>
-#include <boost/regex.hpp>
 
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <ratio>
+#include <sstream>
 #include <string>
-#include <string_view>
+#include <thread>
 
 namespace mastorss
 {
-using boost::regex;
-using boost::regex_replace;
 using std::string;
-using std::string_view;
+using std::chrono::seconds;
+using std::this_thread::sleep_for;
 
-MastoAPI::MastoAPI(ProfileData &data)
-    : _profile{data}
-    , _instance{_profile.instance, _profile.access_token}
-{}
+namespace
+{
+using curl_long = long; // NOLINT(google-runtime-int)
+
+//! Format a time point as ISO 8601 in UTC.
+string format_time(const system_clock::time_point time)
+{
+    const std::time_t time_c{system_clock::to_time_t(time)};
+    std::tm tm{};
+    gmtime_r(&time_c, &tm);
+
+    string buffer(sizeof("1970-01-01T00:00:00Z"), '\0');
+    buffer.resize(std::strftime(buffer.data(), buffer.size(),
+                                "%Y-%m-%dT%H:%M:%SZ", &tm));
+    return buffer;
+}
+
+string to_hex(const std::uint64_t value)
+{
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << value;
+    return hex.str();
+}
 
-void MastoAPI::post_item(const Item &item, bool dry_run)
+//! Removes the request headers of a handle when it goes out of scope.
+class headers_reset
 {
-    string title = replacements_apply(item.title);
-    string link = replacements_apply(item.link);
+public:
+    explicit headers_reset(CURL *handle)
+        : _handle{handle}
+    {}
 
-    // clang-format off
-    string status{[&]
+    ~headers_reset()
     {
-        if (_profile.titles_as_cw)
-        {
-            if (_profile.titles_only)
-            {
-                return string{};
-            }
-            return replacements_apply(item.description);
-        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        curl_easy_setopt(_handle, CURLOPT_HTTPHEADER, nullptr);
+    }
 
-        string s{title};
-        if (!_profile.titles_only)
-        {
-            s.append("\n\n" + replacements_apply(item.description));
-        }
-        return s;
-    }()};
-    // clang-format on
+    headers_reset(const headers_reset &other) = delete;
+    headers_reset(headers_reset &&other) = delete;
+    headers_reset &operator=(const headers_reset &other) = delete;
+    headers_reset &operator=(headers_reset &&other) = delete;
+
+private:
+    CURL *_handle;
+};
 
-    // clang-format off
-    const size_t len_append{[&]
+//! Server errors, overload and network errors that may go away.
+bool is_transient(const mastodonpp::answer_type &answer)
+{
+    if (answer.curl_error_code != CURLE_OK)
     {
-        if (_profile.append.empty())
+        switch (answer.curl_error_code)
         {
-            return size_t{0};
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+            return true;
+        default:
+            return false;
         }
-        return _profile.append.size() + 2;
-    }()};
-    const size_t len_max{[&]
+    }
+
+    return answer.http_status == 408 || answer.http_status == 429
+           || (answer.http_status >= 500 && answer.http_status < 600);
+}
+
+/*!
+ *  @brief  The time to wait before the next attempt, or nothing to give up.
+ *
+ *  Exponential backoff with jitter, but at least as long as Retry-After.
+ */
+optional<seconds> retry_delay(const mastodonpp::answer_type &answer,
+                              const unsigned attempt)
+{
+    constexpr unsigned max_attempts{4};
+    constexpr seconds backoff_base{2};
+    constexpr seconds max_delay{120};
+
+    if (attempt >= max_attempts || !is_transient(answer))
     {
-        if (_profile.titles_as_cw)
-        {
-            // Subjects (CWs) count into the post length.
-            return _profile.max_size - title.size();
-        }
-        return _profile.max_size;
-    }() - link.size() - 2 - len_append};
-    // clang-format off
-    BOOST_LOG_TRIVIAL(debug)
-        << "Maximum text (without link and appendix) length: " << len_max;
+        return {};
+    }
 
-    if (status.size() > len_max)
+    static std::minstd_rand generator{std::random_device{}()};
+    const seconds backoff{backoff_base * (1U << (attempt - 1))};
+    std::uniform_int_distribution<seconds::rep> jitter{backoff.count() / 2,
+                                                       backoff.count()};
+    seconds delay{jitter(generator)};
+
+    const auto retry_after{
+        parse_retry_after(answer.get_header("Retry-After"))};
+    if (retry_after)
+    {
+        delay = std::max(delay, *retry_after);
+    }
+    if (delay > max_delay)
     {
-        constexpr string_view omission = " […]";
-        status.resize(len_max - omission.size());
+        return {};
+    }
 
-        // Don't cut in the middle of a word.
-        const auto pos = status.rfind(' ');
-        if (pos != string::npos)
-        {
-            status.resize(pos);
-        }
+    return delay;
+}
+} // namespace
+
+MastoAPI::MastoAPI(const string_view profile, ProfileData &data,
+                   const CompiledProfile &compiled,
+                   curl_wrapper::CURLPool &pool)
+    : _profile_name{profile}
+    , _profile{data}
+    , _compiled{compiled}
+    , _instance{_profile.instance, _profile.access_token}
+    , _connection{_instance}
+    // The limit is per account, the token tells them apart without being
+    // written to disk.
+    , _ratelimit{Config::get_config_dir()
+                 / ("ratelimit-" + _profile.instance + '-'
+                    + to_hex(fnv1a_64(_profile.access_token)) + ".json")}
+    , _deadline{pool.deadline()}
+{
+    CURL *handle{_connection.get_curl_easy_handle()};
+    pool.share(handle);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT,
+                     static_cast<curl_long>(_profile.connect_timeout));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(handle, CURLOPT_LOW_SPEED_LIMIT,
+                     static_cast<curl_long>(_profile.low_speed_limit));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(handle, CURLOPT_LOW_SPEED_TIME,
+                     static_cast<curl_long>(_profile.low_speed_time));
+}
 
-        status.append(omission);
-        BOOST_LOG_TRIVIAL(debug) << "Status resized to: " << status.size();
+void MastoAPI::post_item(const Item &item, const bool dry_run,
+                         const optional<system_clock::time_point> scheduled_at)
+{
+    while (const auto delay{post(item, dry_run, scheduled_at)})
+    {
+        sleep_for(*delay);
     }
+}
 
-    status.append("\n\n" + link);
+optional<seconds> MastoAPI::try_post_item(const Item &item, const bool dry_run)
+{
+    return post(item, dry_run, {});
+}
+
+optional<seconds>
+MastoAPI::post(const Item &item, const bool dry_run,
+               const optional<system_clock::time_point> scheduled_at)
+{
+    const string title{_compiled.apply_replacements(item.title)};
+    const string link{_compiled.apply_replacements(item.link)};
+    const string description{
+        _profile.titles_only ? string{}
+                             : _compiled.apply_replacements(item.description)};
 
-    if (!_profile.append.empty())
+    size_t max_size{_profile.max_size};
+    if (_profile.titles_as_cw)
     {
-        status.append("\n\n" + _profile.append);
+        // Subjects (CWs) count into the post length.
+        const size_t len_title{count_code_points(title)};
+        max_size = (max_size > len_title) ? max_size - len_title : 0;
     }
-    BOOST_LOG_TRIVIAL(debug) << "Status length: " << status.size();
+
+    string &status{_status};
+    _compiled.post_template().render({title, description, link,
+                                      _profile.append},
+                                     max_size, status);
+    BOOST_LOG_TRIVIAL(debug) << "Status length: " << status_length(status);
     BOOST_LOG_TRIVIAL(debug) << "Status: \"" << status << '"';
 
     if (!dry_run)
@@ -118,17 +228,9 @@ void MastoAPI::post_item(const Item &item, bool dry_run)
             params.insert({"spoiler_text", title});
         }
 
-        mastodonpp::Connection connection{_instance};
-        const auto ret = connection.post(mastodonpp::API::v1::statuses, params);
-        if (!ret)
+        if (const auto delay{post_status(params, item.guid, scheduled_at)})
         {
-            if (ret.http_status != 200)
-            {
-                BOOST_LOG_TRIVIAL(debug) << "Error message from server: "
-                                         << ret.body;
-                throw HTTPException{ret.http_status};
-            }
-            throw CURLException{ret.curl_error_code};
+            return delay;
         }
     }
     else
@@ -139,24 +241,116 @@ void MastoAPI::post_item(const Item &item, bool dry_run)
         {
             cout << "Subject: " << title << '\n';
         }
+        if (scheduled_at)
+        {
+            cout << "Scheduled at: " << format_time(*scheduled_at) << '\n';
+        }
         cout << "Status:\n" << status << '\n';
     }
     BOOST_LOG_TRIVIAL(debug) << "Posted status with GUID: " << item.guid;
 
-    _profile.guids.push_back(item.guid);
-    if (_profile.guids.size() > Config::max_guids)
+    _profile.guids.push(item.guid);
+
+    return {};
+}
+
+optional<seconds>
+MastoAPI::post_status(mastodonpp::parametermap params, const string_view guid,
+                      const optional<system_clock::time_point> scheduled_at)
+{
+    // Only for this request, the connection is used for other requests too.
+    const string header{"Idempotency-Key: " + idempotency_key(guid)};
+    const std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)> headers{
+        curl_slist_append(nullptr, header.c_str()), curl_slist_free_all};
+    CURL *handle{_connection.get_curl_easy_handle()};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers.get());
+    const headers_reset reset{handle};
+
+    const unsigned attempt{(guid == _retry_guid) ? _attempt : 1};
+    _retry_guid.clear();
+
+    // Retries take time, the instance rejects times that are too close. The
+    // parameters only reference their values.
+    const string time{
+        scheduled_at ? format_time(std::max(*scheduled_at,
+                                            system_clock::now()
+                                                + min_schedule_delay))
+                     : ""};
+    if (scheduled_at)
     {
-        _profile.guids.pop_front();
+        params.insert({"scheduled_at", time});
     }
+
+    set_request_timeout();
+    const auto ret{_connection.post(mastodonpp::API::v1::statuses, params)};
+    _ratelimit.update(ret.get_header("X-RateLimit-Limit"),
+                      ret.get_header("X-RateLimit-Remaining"),
+                      ret.get_header("X-RateLimit-Reset"));
+    if (ret.http_status == 429
+        && ret.get_header("X-RateLimit-Remaining").empty())
+    {
+        constexpr seconds default_wait{300};
+        _ratelimit.exhaust(
+            system_clock::now()
+            + parse_retry_after(ret.get_header("Retry-After"))
+                  .value_or(default_wait));
+    }
+    if (ret)
+    {
+        return {};
+    }
+
+    auto delay{retry_delay(ret, attempt)};
+    if (delay && _deadline && steady_clock::now() + *delay >= *_deadline)
+    {
+        delay.reset();
+    }
+    if (!delay)
+    {
+        if (ret.http_status != 200)
+        {
+            BOOST_LOG_TRIVIAL(debug) << "Error message from server: "
+                                     << ret.body;
+            throw HTTPException{ret.http_status};
+        }
+        throw CURLException{ret.curl_error_code};
+    }
+
+    BOOST_LOG_TRIVIAL(warning)
+        << "Posting failed (HTTP " << ret.http_status << ", curl "
+        << static_cast<int>(ret.curl_error_code) << "), retrying in "
+        << delay->count() << " seconds.";
+    _retry_guid = guid;
+    _attempt = attempt + 1;
+
+    return delay;
 }
 
-string MastoAPI::replacements_apply(const string &text)
+void MastoAPI::set_request_timeout()
 {
-    string out = text;
-    for (const auto &replacement : _profile.replacements)
+    using std::chrono::milliseconds;
+    milliseconds timeout{seconds{_profile.timeout}};
+    if (_deadline)
     {
-        out = regex_replace(out, regex{replacement.first}, replacement.second);
+        const auto left{std::chrono::ceil<milliseconds>(
+            *_deadline - steady_clock::now())};
+        if (left <= milliseconds{0})
+        {
+            throw CURLException{CURLE_OPERATION_TIMEDOUT};
+        }
+        timeout = (timeout > milliseconds{0}) ? std::min(timeout, left) : left;
     }
-    return out;
+
+    const std::chrono::duration<curl_long, std::milli> timeout_ms{timeout};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(_connection.get_curl_easy_handle(), CURLOPT_TIMEOUT_MS,
+                     timeout_ms.count());
+}
+
+string MastoAPI::idempotency_key(const string_view guid) const
+{
+    const auto profile_hash{fnv1a_64({"\0", 1}, fnv1a_64(_profile_name))};
+    return "mastorss-" + to_hex(fnv1a_64(guid, profile_hash));
 }
 } // namespace mastorss
@@ -18,28 +18,128 @@
 #define MASTORSS_MASTOAPI_HPP
 
 #include "config.hpp"
+#include "curl_pool.hpp"
 #include "document.hpp"
+#include "rate_limiter.hpp"
 
 #include <mastodonpp/mastodonpp.hpp>
 
+#include <chrono>
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace mastorss
 {
+using std::optional;
 using std::string;
+using std::string_view;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
 
 class MastoAPI
 {
 public:
-    explicit MastoAPI(ProfileData &data);
+    /*!
+     *  @brief  Set up the connection to the instance.
+     *
+     *  The connection is kept open between posts and shares its caches with
+     *  the handles in `pool`. Requests stop at the deadline of `pool`.
+     *
+     *  @param  profile  The name of the profile, used for idempotency keys.
+     *
+     *  @since  0.14.0
+     */
+    MastoAPI(string_view profile, ProfileData &data,
+             const CompiledProfile &compiled, curl_wrapper::CURLPool &pool);
 
-    void post_item(const Item &item, bool dry_run);
+    /*!
+     *  @brief  Mastodon only schedules statuses at least 5 minutes ahead.
+     *
+     *  Includes a margin for clocks that are off.
+     *
+     *  @since  0.14.0
+     */
+    static constexpr std::chrono::seconds min_schedule_delay{330};
+
+    /*!
+     *  @brief  Post an item.
+     *
+     *  If `scheduled_at` is set, the status is published by the instance at
+     *  that time. It has to be at least #min_schedule_delay in the future.
+     *
+     *  Every status carries an idempotency key derived from the profile and
+     *  the GUID, so the instance creates it only once, even if the request is
+     *  repeated. Server errors and transient network errors are retried a few
+     *  times with exponential backoff, honoring `Retry-After`. A
+     *  `scheduled_at` that came too close while retrying is moved back to
+     *  #min_schedule_delay.
+     *
+     *  @since  0.14.0
+     */
+    void post_item(const Item &item, bool dry_run,
+                   optional<system_clock::time_point> scheduled_at = {});
+
+    /*!
+     *  @brief  Like post_item(), but return instead of waiting for a retry.
+     *
+     *  @return Empty if the item was posted, otherwise the time to wait before
+     *          calling it again with the same item.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] optional<std::chrono::seconds>
+    try_post_item(const Item &item, bool dry_run);
+
+    /*!
+     *  @brief  Take one post from the rate limit of the account.
+     *
+     *  The allowance is shared by all profiles that post to the same account.
+     *
+     *  @return Empty if the next post can be made now, otherwise the time the
+     *          allowance is renewed.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] inline optional<system_clock::time_point> reserve_post()
+    {
+        return _ratelimit.reserve();
+    }
 
 private:
+    const string _profile_name;
     ProfileData &_profile;
+    const CompiledProfile &_compiled;
     mastodonpp::Instance _instance;
+    mastodonpp::Connection _connection;
+    string _status; //!< Reused for every post.
+    RateLimiter _ratelimit;
+    const optional<steady_clock::time_point> _deadline;
+    string _retry_guid; //!< The GUID of the item that waits for a retry.
+    unsigned _attempt{1};
+
+    //! Post the item once, see try_post_item().
+    [[nodiscard]] optional<std::chrono::seconds>
+    post(const Item &item, bool dry_run,
+         optional<system_clock::time_point> scheduled_at);
+
+    /*!
+     *  @brief  Make one attempt to post the status.
+     *
+     *  @return The time to wait before the next attempt, if the error is
+     *          transient.
+     */
+    [[nodiscard]] optional<std::chrono::seconds>
+    post_status(mastodonpp::parametermap params, string_view guid,
+                optional<system_clock::time_point> scheduled_at);
 
-    string replacements_apply(const string &text);
+    /*!
+     *  @brief  Limit the next request to the timeout and the deadline.
+     *
+     *  Throws CURLException if the deadline has passed.
+     */
+    void set_request_timeout();
+    [[nodiscard]] string idempotency_key(string_view guid) const;
 };
 } // namespace mastorss
 
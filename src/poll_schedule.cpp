@@ -0,0 +1,190 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "poll_schedule.hpp"
+
+#include "util.hpp"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace mastorss
+{
+using std::int64_t;
+using std::max;
+using std::min;
+using std::string;
+using std::vector;
+
+namespace
+{
+//! Seconds from now until the HTTP date, if it is in the future.
+optional<seconds> until_date(const string_view date)
+{
+    const std::time_t time{curl_getdate(string(date).c_str(), nullptr)};
+    if (time < 0)
+    {
+        return {};
+    }
+    const auto delay{system_clock::from_time_t(time) - system_clock::now()};
+    return max(std::chrono::ceil<seconds>(delay), seconds{0});
+}
+
+string_view trim(string_view text)
+{
+    const size_t start{text.find_first_not_of(" \t\r\n")};
+    if (start == string_view::npos)
+    {
+        return {};
+    }
+    text.remove_prefix(start);
+    return text.substr(0, text.find_last_not_of(" \t\r\n") + 1);
+}
+} // namespace
+
+optional<seconds> parse_retry_after(const string_view value)
+{
+    if (value.empty())
+    {
+        return {};
+    }
+    if (const auto delay{parse_integer(value)})
+    {
+        return seconds{*delay};
+    }
+
+    return until_date(value);
+}
+
+seconds http_poll_hint(const curl_wrapper::answer &answer)
+{
+    seconds hint{0};
+
+    string cache_control{answer.get_header("Cache-Control")};
+    std::transform(cache_control.begin(), cache_control.end(),
+                   cache_control.begin(),
+                   [](const unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    const string_view max_age{"max-age="};
+    const size_t pos{cache_control.find(max_age)};
+    if (pos != string::npos)
+    {
+        string_view value{cache_control};
+        value.remove_prefix(pos + max_age.size());
+        value = trim(value.substr(0, value.find(',')));
+        hint = seconds{parse_integer(value).value_or(0)};
+    }
+    else if (const auto expires{until_date(answer.get_header("Expires"))})
+    {
+        hint = *expires;
+    }
+
+    return max(hint, parse_retry_after(answer.get_header("Retry-After"))
+                         .value_or(seconds{0}));
+}
+
+seconds feed_poll_hint(const string_view ttl, const string_view period,
+                       const string_view frequency)
+{
+    seconds hint{0};
+    if (const auto minutes{parse_integer(trim(ttl))})
+    {
+        hint = std::chrono::minutes{*minutes};
+    }
+
+    if (trim(period).empty() && trim(frequency).empty())
+    {
+        return hint;
+    }
+    seconds length{24 * 60 * 60}; // The default is daily.
+    const string_view name{trim(period)};
+    if (name == "hourly")
+    {
+        length = seconds{60 * 60};
+    }
+    else if (name == "weekly")
+    {
+        length = seconds{7 * 24 * 60 * 60};
+    }
+    else if (name == "monthly")
+    {
+        length = seconds{30 * 24 * 60 * 60};
+    }
+    else if (name == "yearly")
+    {
+        length = seconds{365 * 24 * 60 * 60};
+    }
+    const int64_t updates{
+        max(parse_integer(trim(frequency)).value_or(1), int64_t{1})};
+
+    return max(hint, length / updates);
+}
+
+optional<seconds> not_due(const ProfileData &data,
+                          const system_clock::time_point now)
+{
+    const auto wait{system_clock::from_time_t(data.next_check) - now};
+    if (wait <= due_tolerance)
+    {
+        return {};
+    }
+    return std::chrono::duration_cast<seconds>(wait);
+}
+
+void plan_next_check(ProfileData &data, const bool new_items,
+                     const seconds hint, const system_clock::time_point now)
+{
+    const int64_t now_c{system_clock::to_time_t(now)};
+    // The first check counts as an arrival, so that feeds that never change
+    // are checked less often too.
+    if (new_items || data.arrivals.empty())
+    {
+        data.arrivals.push_back(now_c);
+        while (data.arrivals.size() > max_arrivals)
+        {
+            data.arrivals.pop_front();
+        }
+    }
+
+    vector<int64_t> gaps;
+    for (auto it{data.arrivals.begin()};
+         std::next(it) != data.arrivals.end(); ++it)
+    {
+        gaps.push_back(max(*std::next(it) - *it, int64_t{0}));
+    }
+    int64_t typical{0};
+    if (!gaps.empty())
+    {
+        const auto median{gaps.begin()
+                          + static_cast<std::ptrdiff_t>(gaps.size() / 2)};
+        std::nth_element(gaps.begin(), median, gaps.end());
+        typical = *median;
+    }
+    typical = max(typical, (now_c - data.arrivals.back()) / 2);
+
+    const seconds interval{min(max(seconds{typical / 2}, hint),
+                               seconds{data.max_check_interval})};
+    data.next_check = system_clock::to_time_t(now + interval);
+}
+} // namespace mastorss
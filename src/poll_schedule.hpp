@@ -0,0 +1,114 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_POLL_SCHEDULE_HPP
+#define MASTORSS_POLL_SCHEDULE_HPP
+
+#include "config.hpp"
+#include "curl_wrapper.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace mastorss
+{
+using std::optional;
+using std::string_view;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+/*!
+ *  @brief  Number of arrivals that are remembered per profile.
+ *
+ *  @since  0.14.0
+ */
+constexpr size_t max_arrivals{16};
+
+/*!
+ *  @brief  Checks that are early by up to this much are done anyway.
+ *
+ *  Keeps a check that is due every few minutes from being skipped because
+ *  the previous run took a few seconds.
+ *
+ *  @since  0.14.0
+ */
+constexpr seconds due_tolerance{60};
+
+/*!
+ *  @brief  Parse the value of a `Retry-After` header.
+ *
+ *  It is either a number of seconds or a HTTP date.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] optional<seconds> parse_retry_after(string_view value);
+
+/*!
+ *  @brief  The time the server asks us not to download the feed again.
+ *
+ *  Uses `Cache-Control: max-age`, `Expires` if there is no `max-age`, and
+ *  `Retry-After`, whichever is longest.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] seconds http_poll_hint(const curl_wrapper::answer &answer);
+
+/*!
+ *  @brief  The time the feed asks us not to download it again.
+ *
+ *  @param  ttl       The `<ttl>` of the channel, in minutes.
+ *  @param  period    The `<sy:updatePeriod>` of the channel.
+ *  @param  frequency The `<sy:updateFrequency>` of the channel.
+ *
+ *  Empty values are ignored.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] seconds feed_poll_hint(string_view ttl, string_view period,
+                                     string_view frequency);
+
+/*!
+ *  @brief  Returns how much too early a check of the feed is.
+ *
+ *  @return Empty if the feed is due.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] optional<seconds> not_due(const ProfileData &data,
+                                        system_clock::time_point now);
+
+/*!
+ *  @brief  Learn from a check of the feed and plan the next one.
+ *
+ *  Records the time if new items were found. The next check is at half the
+ *  typical time between arrivals, at least as late as `hint` and at most
+ *  `max_check_interval` seconds away. The longer a feed stays quiet, the
+ *  longer the typical time between arrivals gets.
+ *
+ *  @param  data      The profile.
+ *  @param  new_items `true` if the check found new items.
+ *  @param  hint      The longest of the hints of the server and the feed.
+ *  @param  now       The time of the check.
+ *
+ *  @since  0.14.0
+ */
+void plan_next_check(ProfileData &data, bool new_items, seconds hint,
+                     system_clock::time_point now);
+} // namespace mastorss
+
+#endif // MASTORSS_POLL_SCHEDULE_HPP
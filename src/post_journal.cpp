@@ -0,0 +1,419 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "post_journal.hpp"
+
+#include "exceptions.hpp"
+#include "util.hpp"
+
+#include <boost/log/trivial.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+namespace mastorss
+{
+using std::move;
+using std::optional;
+using std::uint32_t;
+
+namespace
+{
+constexpr string_view magic{"MRSSJRNL"};
+constexpr uint32_t version{1};
+constexpr size_t header_size{magic.size() + sizeof(uint32_t)};
+constexpr size_t record_header_size{1 + 2 * sizeof(uint32_t)};
+constexpr char type_item{'I'};
+constexpr char type_commit{'C'};
+
+void put_u32(string &out, const uint32_t value)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+uint32_t get_u32(const string_view in, const size_t pos)
+{
+    uint32_t value{0};
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    return value;
+}
+
+void put_string(string &out, const string_view value)
+{
+    put_u32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+optional<string> get_string(const string_view in, size_t &pos)
+{
+    if (in.size() - pos < sizeof(uint32_t))
+    {
+        return {};
+    }
+    const size_t size{get_u32(in, pos)};
+    pos += sizeof(uint32_t);
+    if (in.size() - pos < size)
+    {
+        return {};
+    }
+    string value{in.substr(pos, size)};
+    pos += size;
+    return value;
+}
+
+//! FNV-1a over the type and the payload.
+uint32_t checksum(const char type, const string_view payload)
+{
+    return fnv1a_32(payload, fnv1a_32({&type, 1}));
+}
+
+void add_record(string &out, const char type, const string_view payload)
+{
+    out += type;
+    put_u32(out, static_cast<uint32_t>(payload.size()));
+    put_u32(out, checksum(type, payload));
+    out.append(payload);
+}
+
+string encode(const Item &item)
+{
+    string payload;
+    payload.reserve(4 * sizeof(uint32_t) + item.guid.size() + item.title.size()
+                    + item.link.size() + item.description.size());
+    put_string(payload, item.guid);
+    put_string(payload, item.title);
+    put_string(payload, item.link);
+    put_string(payload, item.description);
+    return payload;
+}
+
+optional<Item> decode(const string_view payload)
+{
+    size_t pos{0};
+    auto guid{get_string(payload, pos)};
+    auto title{get_string(payload, pos)};
+    auto link{get_string(payload, pos)};
+    auto description{get_string(payload, pos)};
+    if (!guid || !title || !link || !description || pos != payload.size())
+    {
+        return {};
+    }
+    return Item{move(*description), move(*guid), move(*link), move(*title)};
+}
+
+//! Make the directory entry of a new file durable.
+void sync_directory(const fs::path &path)
+{
+    const int fd{::open(path.parent_path().c_str(),
+                        O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+    if (fd >= 0)
+    {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+} // namespace
+
+PostJournal::~PostJournal() noexcept
+{
+    if (_fd >= 0)
+    {
+        ::close(_fd);
+    }
+}
+
+PostJournal::PostJournal(PostJournal &&other) noexcept
+    : _path{move(other._path)}
+    , _fd{std::exchange(other._fd, -1)}
+    , _unsynced{other._unsynced}
+    , _pending{move(other._pending)}
+    , _committed{move(other._committed)}
+{}
+
+PostJournal &PostJournal::operator=(PostJournal &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+        }
+        _path = move(other._path);
+        _fd = std::exchange(other._fd, -1);
+        _unsynced = other._unsynced;
+        _pending = move(other._pending);
+        _committed = move(other._committed);
+    }
+    return *this;
+}
+
+void PostJournal::open(const fs::path &path, const bool read_only)
+{
+    if (_fd >= 0)
+    {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _path = path;
+    _pending.clear();
+    _committed.clear();
+
+    const bool exists{fs::exists(path)};
+    const size_t valid{exists ? read(path) : 0};
+    if (read_only)
+    {
+        return;
+    }
+
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (_fd < 0)
+    {
+        fail("open");
+    }
+
+    const auto size{::lseek(_fd, 0, SEEK_END)};
+    if (size < static_cast<off_t>(header_size))
+    {
+        string header{magic};
+        put_u32(header, version);
+        if (::ftruncate(_fd, 0) != 0)
+        {
+            fail("truncate");
+        }
+        write(header);
+        sync();
+        if (!exists)
+        {
+            sync_directory(path);
+            BOOST_LOG_TRIVIAL(debug) << "Created journal " << path;
+        }
+    }
+    else
+    {
+        if (static_cast<off_t>(valid) < size)
+        {
+            BOOST_LOG_TRIVIAL(warning) << "Discarding incomplete record at "
+                                          "the end of "
+                                       << path << '.';
+            if (::ftruncate(_fd, static_cast<off_t>(valid)) != 0)
+            {
+                fail("truncate");
+            }
+        }
+        BOOST_LOG_TRIVIAL(debug)
+            << "Journal " << path << ": " << _pending.size()
+            << " pending items, " << _committed.size() << " committed.";
+    }
+}
+
+size_t PostJournal::read(const fs::path &path)
+{
+    std::ifstream file{path.c_str(), std::ios::binary};
+    const string data{std::istreambuf_iterator<char>{file},
+                      std::istreambuf_iterator<char>{}};
+    if (data.size() < header_size)
+    {
+        return 0; // Interrupted while creating it.
+    }
+    if (string_view(data).substr(0, magic.size()) != magic
+        || get_u32(data, magic.size()) != version)
+    {
+        throw FileException{path.string() + " is not a journal."};
+    }
+
+    size_t pos{header_size};
+    while (data.size() - pos >= record_header_size)
+    {
+        const char type{data[pos]};
+        const size_t size{get_u32(data, pos + 1)};
+        const uint32_t sum{get_u32(data, pos + 1 + sizeof(uint32_t))};
+        if (data.size() - pos - record_header_size < size)
+        {
+            break;
+        }
+        const string_view payload{
+            string_view(data).substr(pos + record_header_size, size)};
+        if (checksum(type, payload) != sum)
+        {
+            break;
+        }
+
+        if (type == type_item)
+        {
+            auto item{decode(payload)};
+            if (!item)
+            {
+                break;
+            }
+            _pending.push_back(move(*item));
+        }
+        else if (type == type_commit)
+        {
+            const auto it{std::find_if(_pending.begin(), _pending.end(),
+                                       [&payload](const Item &item)
+                                       { return item.guid == payload; })};
+            if (it != _pending.end())
+            {
+                _pending.erase(it);
+            }
+            _committed.emplace_back(payload);
+        }
+        else
+        {
+            break;
+        }
+        pos += record_header_size + size;
+    }
+
+    return pos;
+}
+
+void PostJournal::restore(GUIDHistory &guids)
+{
+    for (const auto &guid : _committed)
+    {
+        if (!guids.contains(guid))
+        {
+            guids.push(guid);
+        }
+    }
+
+    vector<string> posted;
+    for (const auto &item : _pending)
+    {
+        if (guids.contains(item.guid))
+        {
+            posted.push_back(item.guid);
+        }
+    }
+    for (const auto &guid : posted)
+    {
+        BOOST_LOG_TRIVIAL(debug) << "Already posted: " << guid;
+        commit(guid);
+    }
+    sync();
+}
+
+void PostJournal::append(const list<Item> &items)
+{
+    if (items.empty())
+    {
+        return;
+    }
+
+    string records;
+    for (const auto &item : items)
+    {
+        if (std::any_of(_pending.begin(), _pending.end(),
+                        [&item](const Item &pending)
+                        { return pending.guid == item.guid; }))
+        {
+            continue;
+        }
+        add_record(records, type_item, encode(item));
+        _pending.push_back(item);
+    }
+    write(records);
+    sync();
+}
+
+void PostJournal::commit(const string_view guid)
+{
+    const auto it{std::find_if(_pending.begin(), _pending.end(),
+                               [&guid](const Item &item)
+                               { return item.guid == guid; })};
+    if (it != _pending.end())
+    {
+        _pending.erase(it);
+    }
+    _committed.emplace_back(guid);
+
+    string record;
+    add_record(record, type_commit, guid);
+    write(record);
+}
+
+void PostJournal::sync()
+{
+    if (_fd < 0 || !_unsynced)
+    {
+        return;
+    }
+    if (::fdatasync(_fd) != 0)
+    {
+        fail("sync");
+    }
+    _unsynced = false;
+}
+
+void PostJournal::clear()
+{
+    _pending.clear();
+    _committed.clear();
+    if (_fd < 0)
+    {
+        return;
+    }
+
+    if (::ftruncate(_fd, static_cast<off_t>(header_size)) != 0)
+    {
+        fail("truncate");
+    }
+    _unsynced = true;
+    sync();
+}
+
+void PostJournal::write(const string &records)
+{
+    if (_fd < 0)
+    {
+        return;
+    }
+
+    size_t pos{0};
+    while (pos < records.size())
+    {
+        const auto written{
+            ::write(_fd, records.data() + pos, records.size() - pos)};
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fail("write");
+        }
+        pos += static_cast<size_t>(written);
+    }
+    _unsynced = true;
+}
+
+void PostJournal::fail(const string &action) const
+{
+    throw FileException{"Could not " + action + " journal " + _path.string()
+                        + ": " + std::strerror(errno)};
+}
+} // namespace mastorss
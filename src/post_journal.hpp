@@ -0,0 +1,171 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_POST_JOURNAL_HPP
+#define MASTORSS_POST_JOURNAL_HPP
+
+#include "guid_history.hpp"
+#include "item.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastorss
+{
+namespace fs = boost::filesystem;
+using std::list;
+using std::string;
+using std::string_view;
+using std::vector;
+
+/*!
+ *  @brief  Durable record of the items that are about to be posted.
+ *
+ *  New items are appended to the journal before they are posted and every
+ *  posted item is committed. If mastorss is interrupted, the next run posts
+ *  the pending items from the journal instead of downloading the feed again.
+ *
+ *  The journal is an append-only file of checksummed records. A record that
+ *  was only partially written is discarded when the journal is opened.
+ *  Commits are written immediately but only synced to disk by sync(), so
+ *  several commits can share one fsync.
+ *
+ *  @since  0.14.0
+ */
+class PostJournal
+{
+public:
+    //! Construct a journal that is not backed by a file. @since  0.14.0
+    PostJournal() = default;
+
+    ~PostJournal() noexcept;
+
+    //! Copy constructor. @since  0.14.0
+    PostJournal(const PostJournal &other) = delete;
+
+    //! Move constructor. @since  0.14.0
+    PostJournal(PostJournal &&other) noexcept;
+
+    //! Copy assignment operator. @since  0.14.0
+    PostJournal &operator=(const PostJournal &other) = delete;
+
+    //! Move assignment operator. @since  0.14.0
+    PostJournal &operator=(PostJournal &&other) noexcept;
+
+    /*!
+     *  @brief  Open the journal file and read the pending items.
+     *
+     *  The file is created if it does not exist, unless `read_only` is set.
+     *  A read-only journal keeps track of the items in memory only.
+     *
+     *  Throws FileException if the file can not be used.
+     *
+     *  @since  0.14.0
+     */
+    void open(const fs::path &path, bool read_only = false);
+
+    //! The items that were not committed yet, in order. @since  0.14.0
+    [[nodiscard]] inline const list<Item> &pending() const
+    {
+        return _pending;
+    }
+
+    /*!
+     *  @brief  Reconcile the journal with the GUID history.
+     *
+     *  Adds the GUIDs of committed items that `guids` is missing and commits
+     *  pending items that are already in `guids`, because they were posted
+     *  right before an interruption.
+     *
+     *  Throws FileException on error.
+     *
+     *  @since  0.14.0
+     */
+    void restore(GUIDHistory &guids);
+
+    /*!
+     *  @brief  Append items and sync them to disk.
+     *
+     *  Items that are already pending are skipped.
+     *
+     *  Throws FileException on error.
+     *
+     *  @since  0.14.0
+     */
+    void append(const list<Item> &items);
+
+    /*!
+     *  @brief  Mark the item as posted.
+     *
+     *  The record is written, but only synced with the next sync().
+     *
+     *  Throws FileException on error.
+     *
+     *  @since  0.14.0
+     */
+    void commit(string_view guid);
+
+    /*!
+     *  @brief  Sync the commits to disk.
+     *
+     *  Throws FileException on error.
+     *
+     *  @since  0.14.0
+     */
+    void sync();
+
+    /*!
+     *  @brief  Forget the pending items.
+     *
+     *  They are removed from the file by the next clear().
+     *
+     *  @since  0.14.0
+     */
+    inline void discard()
+    {
+        _pending.clear();
+    }
+
+    /*!
+     *  @brief  Forget all items.
+     *
+     *  The GUIDs of committed items must have been saved elsewhere before.
+     *
+     *  Throws FileException on error.
+     *
+     *  @since  0.14.0
+     */
+    void clear();
+
+private:
+    fs::path _path;
+    int _fd{-1};
+    bool _unsynced{false};
+    list<Item> _pending;
+    vector<string> _committed;
+
+    //! Returns the size of the complete records, including the header.
+    [[nodiscard]] size_t read(const fs::path &path);
+    void write(const string &records);
+    [[noreturn]] void fail(const string &action) const;
+};
+} // namespace mastorss
+
+#endif // MASTORSS_POST_JOURNAL_HPP
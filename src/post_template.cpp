@@ -0,0 +1,168 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "post_template.hpp"
+
+#include "exceptions.hpp"
+#include "text_length.hpp"
+
+#include <boost/log/trivial.hpp>
+
+namespace mastorss
+{
+PostTemplate::PostTemplate(const string_view text)
+{
+    string literal;
+    const auto add_op{[this, &literal](const field type)
+                      {
+                          if (!literal.empty())
+                          {
+                              _ops.push_back({field::text, literal});
+                              literal.clear();
+                          }
+                          if (type != field::text)
+                          {
+                              _ops.push_back({type, {}});
+                          }
+                      }};
+
+    size_t pos{0};
+    while (pos < text.size())
+    {
+        const char c{text[pos]};
+        if ((c == '{' || c == '}') && pos + 1 < text.size()
+            && text[pos + 1] == c)
+        {
+            literal += c;
+            pos += 2;
+            continue;
+        }
+        if (c == '}')
+        {
+            throw ConfigException{"Invalid template: Unexpected }."};
+        }
+        if (c != '{')
+        {
+            literal += c;
+            ++pos;
+            continue;
+        }
+
+        const size_t end{text.find('}', pos)};
+        if (end == string_view::npos)
+        {
+            throw ConfigException{"Invalid template: Missing }."};
+        }
+        const string_view name{text.substr(pos + 1, end - pos - 1)};
+        if (name == "title")
+        {
+            add_op(field::title);
+        }
+        else if (name == "description")
+        {
+            add_op(field::description);
+        }
+        else if (name == "link")
+        {
+            add_op(field::link);
+        }
+        else if (name == "append")
+        {
+            add_op(field::append);
+        }
+        else
+        {
+            throw ConfigException{"Invalid template: Unknown field {"
+                                  + string(name) + "}."};
+        }
+        pos = end + 1;
+    }
+    add_op(field::text);
+}
+
+void PostTemplate::render(const fields &values, const size_t max_size,
+                          string &out) const
+{
+    constexpr string_view omission{" […]"};
+
+    size_t size{0};
+    for (const auto &current : _ops)
+    {
+        size += value(current, values).size();
+    }
+    out.clear();
+    out.reserve(size + omission.size());
+
+    size_t text_end{0}; // After the last title or description.
+    for (const auto &current : _ops)
+    {
+        out.append(value(current, values));
+        if (current.type == field::title || current.type == field::description)
+        {
+            text_end = out.size();
+        }
+    }
+
+    if (text_end == 0 || status_length(out) <= max_size)
+    {
+        return;
+    }
+
+    const string_view text{string_view(out).substr(0, text_end)};
+    const size_t len_tail{status_length(string_view(out).substr(text_end))};
+    const size_t len_omission{count_code_points(omission)};
+    size_t max_text{0};
+    if (max_size > len_tail + len_omission)
+    {
+        max_text = max_size - len_tail - len_omission;
+    }
+    BOOST_LOG_TRIVIAL(debug)
+        << "Maximum text (without link and appendix) length: "
+        << max_text + len_omission;
+
+    // Don't cut in the middle of a word.
+    size_t len_text{fit_status(text, max_text)};
+    if (len_text > 0 && len_text < text.size() && text[len_text] != ' ')
+    {
+        const auto pos{text.rfind(' ', len_text - 1)};
+        if (pos != string_view::npos)
+        {
+            len_text = pos;
+        }
+    }
+
+    out.replace(len_text, text_end - len_text, omission);
+    BOOST_LOG_TRIVIAL(debug) << "Status resized to: " << status_length(out);
+}
+
+string_view PostTemplate::value(const op &current, const fields &values)
+{
+    switch (current.type)
+    {
+    case field::text:
+        return current.text;
+    case field::title:
+        return values.title;
+    case field::description:
+        return values.description;
+    case field::link:
+        return values.link;
+    case field::append:
+        return values.append;
+    }
+    return {};
+}
+} // namespace mastorss
@@ -0,0 +1,97 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_POST_TEMPLATE_HPP
+#define MASTORSS_POST_TEMPLATE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastorss
+{
+using std::string;
+using std::string_view;
+using std::vector;
+
+/*!
+ *  @brief  The layout of a post, compiled once.
+ *
+ *  The template is text with the fields `{title}`, `{description}`, `{link}`
+ *  and `{append}`. `{{` and `}}` stand for literal braces.
+ *
+ *  @since  0.14.0
+ */
+class PostTemplate
+{
+public:
+    //! The values of the fields. @since  0.14.0
+    struct fields
+    {
+        string_view title;
+        string_view description;
+        string_view link;
+        string_view append;
+    };
+
+    //! Construct an empty template. @since  0.14.0
+    PostTemplate() = default;
+
+    /*!
+     *  @brief  Compile a template.
+     *
+     *  Throws ConfigException if the template is invalid.
+     *
+     *  @since  0.14.0
+     */
+    explicit PostTemplate(string_view text);
+
+    /*!
+     *  @brief  Render the template into `out`.
+     *
+     *  If the result is longer than `max_size`, the text up to the end of the
+     *  last title or description is shortened at a word boundary and ` […]`
+     *  is appended to it. The length is counted with status_length(). `out`
+     *  is reserved once and reused.
+     *
+     *  @since  0.14.0
+     */
+    void render(const fields &values, size_t max_size, string &out) const;
+
+private:
+    enum class field
+    {
+        text,
+        title,
+        description,
+        link,
+        append
+    };
+
+    struct op
+    {
+        field type{field::text};
+        string text; //!< Only used for field::text.
+    };
+
+    vector<op> _ops;
+
+    [[nodiscard]] static string_view value(const op &current,
+                                           const fields &values);
+};
+} // namespace mastorss
+
+#endif // MASTORSS_POST_TEMPLATE_HPP
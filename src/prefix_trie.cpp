@@ -0,0 +1,122 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "prefix_trie.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace mastorss
+{
+using std::iota;
+using std::lower_bound;
+using std::stable_sort;
+
+PrefixTrie::PrefixTrie(const vector<string_view> &keys)
+{
+    if (keys.empty())
+    {
+        return;
+    }
+
+    // Sort the indices instead of the keys to remember which one came first.
+    vector<size_t> order(keys.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(),
+                [&keys](const size_t a, const size_t b)
+                { return keys[a] < keys[b]; });
+    static_cast<void>(add_node(keys, order, 0, order.size(), 0));
+}
+
+optional<size_t> PrefixTrie::match(const string_view text) const
+{
+    if (_nodes.empty())
+    {
+        return {};
+    }
+
+    const node *current{&_nodes[0]};
+    for (const char c : text)
+    {
+        if (current->key != 0)
+        {
+            break;
+        }
+
+        const auto character{static_cast<unsigned char>(c)};
+        const auto begin{_edges.begin() + current->first_edge};
+        const auto end{begin + current->edges};
+        const auto next{lower_bound(begin, end, character,
+                                    [](const edge &e, const unsigned char ch)
+                                    { return e.character < ch; })};
+        if (next == end || next->character != character)
+        {
+            return {};
+        }
+        current = &_nodes[next->target];
+    }
+
+    if (current->key == 0)
+    {
+        return {};
+    }
+    return current->key - 1;
+}
+
+std::uint32_t PrefixTrie::add_node(const vector<string_view> &keys,
+                                   const vector<size_t> &order, size_t begin,
+                                   const size_t end, const size_t depth)
+{
+    // The keys in [begin, end) are sorted and share the first `depth`
+    // characters, so the one that ends here comes first.
+    const auto index{static_cast<std::uint32_t>(_nodes.size())};
+    _nodes.emplace_back();
+    const string_view first{keys[order[begin]]};
+    if (first.size() == depth)
+    {
+        // Keys below would never be found.
+        _nodes[index].key = static_cast<std::uint32_t>(order[begin] + 1);
+        return index;
+    }
+
+    // One edge per distinct character at `depth`.
+    vector<size_t> groups;
+    for (size_t pos{begin}; pos < end; ++pos)
+    {
+        if (groups.empty()
+            || keys[order[pos]][depth] != keys[order[groups.back()]][depth])
+        {
+            groups.push_back(pos);
+        }
+    }
+
+    const auto first_edge{static_cast<std::uint32_t>(_edges.size())};
+    _nodes[index].first_edge = first_edge;
+    _nodes[index].edges = static_cast<std::uint32_t>(groups.size());
+    _edges.resize(_edges.size() + groups.size());
+    for (size_t group{0}; group < groups.size(); ++group)
+    {
+        begin = groups[group];
+        const size_t group_end{(group + 1 < groups.size()) ? groups[group + 1]
+                                                           : end};
+        const auto target{add_node(keys, order, begin, group_end, depth + 1)};
+        _edges[first_edge + group] = {
+            static_cast<unsigned char>(keys[order[begin]][depth]), target};
+    }
+
+    return index;
+}
+} // namespace mastorss
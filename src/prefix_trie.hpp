@@ -0,0 +1,94 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_PREFIX_TRIE_HPP
+#define MASTORSS_PREFIX_TRIE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace mastorss
+{
+using std::optional;
+using std::string_view;
+using std::vector;
+
+/*!
+ *  @brief  Byte trie for finding keys at the start of a text.
+ *
+ *  Matching does not allocate and looks at every character at most once.
+ *
+ *  @since  0.14.0
+ */
+class PrefixTrie
+{
+public:
+    //! Construct without keys. @since  0.14.0
+    PrefixTrie() = default;
+
+    /*!
+     *  @brief  Build the trie.
+     *
+     *  Keys that start with another key can never be found and are dropped.
+     *
+     *  @since  0.14.0
+     */
+    explicit PrefixTrie(const vector<string_view> &keys);
+
+    /*!
+     *  @brief  Find the key the text starts with.
+     *
+     *  @return The index of the key or an empty optional. If a key occurs more
+     *          than once, the first index is returned.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] optional<size_t> match(string_view text) const;
+
+    //! Returns `true` if the trie has no keys. @since  0.14.0
+    [[nodiscard]] inline bool empty() const
+    {
+        return _nodes.empty();
+    }
+
+private:
+    //! Edges are sorted by character.
+    struct node
+    {
+        std::uint32_t first_edge{0};
+        std::uint32_t edges{0};
+        std::uint32_t key{0}; //!< Index of the key + 1, 0 if no key ends here.
+    };
+
+    struct edge
+    {
+        unsigned char character{0};
+        std::uint32_t target{0};
+    };
+
+    vector<node> _nodes;
+    vector<edge> _edges;
+
+    std::uint32_t add_node(const vector<string_view> &keys,
+                           const vector<size_t> &order, size_t begin,
+                           size_t end, size_t depth);
+};
+} // namespace mastorss
+
+#endif // MASTORSS_PREFIX_TRIE_HPP
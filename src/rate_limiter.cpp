@@ -0,0 +1,167 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rate_limiter.hpp"
+
+#include "state_file.hpp"
+#include "util.hpp"
+
+#include <json/json.h>
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <utility>
+
+namespace mastorss
+{
+using std::int64_t;
+using std::string;
+
+namespace
+{
+//! Parse an ISO 8601 timestamp in UTC or seconds since the epoch.
+optional<int64_t> parse_time(const string_view value)
+{
+    if (const auto seconds{parse_integer(value)})
+    {
+        return seconds;
+    }
+
+    std::tm tm{};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    if (std::sscanf(string(value).c_str(), "%4d-%2d-%2dT%2d:%2d:%2d",
+                    &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour,
+                    &tm.tm_min, &tm.tm_sec)
+        != 6)
+    {
+        return {};
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    return timegm(&tm);
+}
+} // namespace
+
+RateLimiter::RateLimiter(fs::path path)
+    : _path{std::move(path)}
+{}
+
+optional<system_clock::time_point> RateLimiter::reserve()
+{
+    optional<system_clock::time_point> renewal;
+    modify(
+        [&renewal](state &current)
+        {
+            if (current.reset <= unix_now())
+            {
+                // Open a new window, so that only `limit` posts are made until
+                // a response tells the real reset.
+                current.remaining = current.limit;
+                if (current.limit)
+                {
+                    current.reset = unix_now() + assumed_window.count();
+                }
+            }
+            if (!current.remaining)
+            {
+                return; // Nothing known, try it.
+            }
+            if (*current.remaining > 0)
+            {
+                --*current.remaining;
+                return;
+            }
+            renewal = system_clock::from_time_t(current.reset);
+        });
+
+    return renewal;
+}
+
+void RateLimiter::update(const string_view limit, const string_view remaining,
+                         const string_view reset)
+{
+    const auto new_limit{parse_integer(limit)};
+    const auto new_remaining{parse_integer(remaining)};
+    const auto new_reset{parse_time(reset)};
+    if (!new_limit && !new_remaining && !new_reset)
+    {
+        return;
+    }
+
+    modify(
+        [&](state &current)
+        {
+            if (new_limit)
+            {
+                current.limit = new_limit;
+            }
+            if (new_remaining)
+            {
+                current.remaining = new_remaining;
+            }
+            if (new_reset)
+            {
+                current.reset = *new_reset;
+            }
+        });
+}
+
+void RateLimiter::exhaust(const system_clock::time_point reset)
+{
+    modify(
+        [reset](state &current)
+        {
+            current.remaining = 0;
+            current.reset = system_clock::to_time_t(reset);
+        });
+}
+
+void RateLimiter::modify(const std::function<void(state &)> &change)
+{
+    modify_state_file(
+        _path,
+        [&change](Json::Value &json)
+        {
+            state current;
+            if (json["limit"].isInt64())
+            {
+                current.limit = json["limit"].asInt64();
+            }
+            if (json["remaining"].isInt64())
+            {
+                current.remaining = json["remaining"].asInt64();
+            }
+            if (json["reset"].isInt64())
+            {
+                current.reset = json["reset"].asInt64();
+            }
+
+            change(current);
+
+            json = Json::objectValue;
+            if (current.limit)
+            {
+                json["limit"] = Json::Int64{*current.limit};
+            }
+            if (current.remaining)
+            {
+                json["remaining"] = Json::Int64{*current.remaining};
+            }
+            json["reset"] = Json::Int64{current.reset};
+        });
+}
+} // namespace mastorss
@@ -0,0 +1,108 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_RATE_LIMITER_HPP
+#define MASTORSS_RATE_LIMITER_HPP
+
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+namespace mastorss
+{
+namespace fs = boost::filesystem;
+using std::optional;
+using std::string_view;
+using std::chrono::system_clock;
+
+/*!
+ *  @brief  Keeps track of the posting allowance of an account.
+ *
+ *  The allowance is learned from the `X-RateLimit-*` headers of the
+ *  responses and counted down locally between responses. The state is kept
+ *  in a small file that is locked while it is used, so that all processes
+ *  and profiles that post to the same account share it.
+ *
+ *  Problems with the state file are logged and never stop a post.
+ *
+ *  @since  0.14.0
+ */
+class RateLimiter
+{
+public:
+    /*!
+     *  @brief  Assumed length of a window after the reset has passed.
+     *
+     *  Mastodon allows 300 statuses in 3 hours. The next response replaces
+     *  the assumed reset with the real one.
+     *
+     *  @since  0.14.0
+     */
+    static constexpr std::chrono::seconds assumed_window{3 * 60 * 60};
+
+    //! Construct a limiter that allows everything. @since  0.14.0
+    RateLimiter() = default;
+
+    //! Use the state in `path`, it is created when needed. @since  0.14.0
+    explicit RateLimiter(fs::path path);
+
+    /*!
+     *  @brief  Take one post from the allowance.
+     *
+     *  @return Empty if a post can be made now, otherwise the time the
+     *          allowance is renewed.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] optional<system_clock::time_point> reserve();
+
+    /*!
+     *  @brief  Update the allowance from the headers of a response.
+     *
+     *  `reset` can be an ISO 8601 timestamp or seconds since the epoch. Empty
+     *  values are ignored.
+     *
+     *  @since  0.14.0
+     */
+    void update(string_view limit, string_view remaining, string_view reset);
+
+    /*!
+     *  @brief  Mark the allowance as used up until `reset`.
+     *
+     *  @since  0.14.0
+     */
+    void exhaust(system_clock::time_point reset);
+
+private:
+    struct state
+    {
+        optional<std::int64_t> limit;
+        optional<std::int64_t> remaining;
+        std::int64_t reset{0}; //!< Seconds since the epoch.
+    };
+
+    fs::path _path;
+
+    //! Lock the state file, read it, change it and write it back.
+    void modify(const std::function<void(state &)> &change);
+};
+} // namespace mastorss
+
+#endif // MASTORSS_RATE_LIMITER_HPP
@@ -0,0 +1,214 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "replacement_engine.hpp"
+
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace mastorss
+{
+using boost::regex_replace;
+using std::min;
+using std::move;
+
+namespace
+{
+constexpr string_view regex_special{".[]{}()\\*+?|^$"};
+
+/*!
+ *  @brief  Returns the text a pattern matches, if it is a literal.
+ *
+ *  Special characters may be escaped with a backslash.
+ */
+optional<string> literal_pattern(const string_view pattern)
+{
+    if (pattern.empty())
+    {
+        return {};
+    }
+
+    string literal;
+    literal.reserve(pattern.size());
+    for (size_t pos{0}; pos < pattern.size(); ++pos)
+    {
+        char c{pattern[pos]};
+        if (c == '\\')
+        {
+            if (++pos == pattern.size()
+                || regex_special.find(pattern[pos]) == string_view::npos)
+            {
+                return {};
+            }
+            c = pattern[pos];
+        }
+        else if (regex_special.find(c) != string_view::npos)
+        {
+            return {};
+        }
+        literal += c;
+    }
+
+    return literal;
+}
+
+//! Returns `true` if a and b can share characters in a text.
+bool can_overlap(const string_view a, const string_view b)
+{
+    if (a.find(b) != string_view::npos || b.find(a) != string_view::npos)
+    {
+        return true;
+    }
+    for (size_t len{1}; len < min(a.size(), b.size()); ++len)
+    {
+        if (a.substr(a.size() - len) == b.substr(0, len)
+            || b.substr(b.size() - len) == a.substr(0, len))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ *  @brief  Returns `true` if `later` can be applied in the same pass as
+ *          `earlier`.
+ *
+ *  That is the case if their matches never overlap and the replacement of
+ *  `earlier` can not become part of a match of `later`.
+ */
+bool independent(const pair<string, string> &earlier,
+                 const pair<string, string> &later)
+{
+    if (can_overlap(earlier.first, later.first))
+    {
+        return false;
+    }
+    if (earlier.second.empty())
+    {
+        // The text around the deleted match joins.
+        return later.first.size() < 2;
+    }
+    return !can_overlap(earlier.second, later.first);
+}
+} // namespace
+
+ReplacementEngine::ReplacementEngine(
+    const list<pair<string, string>> &replacements, const string &setting)
+{
+    const auto finish_pass{[this]
+                           {
+                               if (_passes.empty()
+                                   || _passes.back().literals.empty())
+                               {
+                                   return;
+                               }
+                               pass &last{_passes.back()};
+                               vector<string_view> keys;
+                               keys.reserve(last.literals.size());
+                               for (const auto &literal : last.literals)
+                               {
+                                   keys.emplace_back(literal.first);
+                               }
+                               last.trie = PrefixTrie{keys};
+                           }};
+
+    for (const auto &replacement : replacements)
+    {
+        auto literal{literal_pattern(replacement.first)};
+        if (!literal
+            || replacement.second.find_first_of("$\\") != string::npos)
+        {
+            finish_pass();
+            pass regex_pass;
+            try
+            {
+                regex_pass.pattern.emplace(replacement.first);
+            }
+            catch (const boost::regex_error &e)
+            {
+                throw ConfigException{"Invalid regular expression in "
+                                      + setting + ": \"" + replacement.first
+                                      + "\": " + e.what()};
+            }
+            regex_pass.format = replacement.second;
+            _passes.push_back(move(regex_pass));
+            continue;
+        }
+
+        pair<string, string> current{move(*literal), replacement.second};
+        const bool join{
+            !_passes.empty() && !_passes.back().literals.empty()
+            && std::all_of(_passes.back().literals.begin(),
+                           _passes.back().literals.end(),
+                           [&current](const pair<string, string> &earlier)
+                           { return independent(earlier, current); })};
+        if (!join)
+        {
+            finish_pass();
+            _passes.emplace_back();
+        }
+        _passes.back().literals.push_back(move(current));
+    }
+    finish_pass();
+}
+
+string ReplacementEngine::apply(string text) const
+{
+    string buffer;
+    for (const auto &current : _passes)
+    {
+        buffer.clear();
+        if (current.pattern)
+        {
+            regex_replace(std::back_inserter(buffer), text.begin(),
+                          text.end(), *current.pattern, current.format);
+        }
+        else
+        {
+            apply_literals(current, text, buffer);
+        }
+        text.swap(buffer);
+    }
+    return text;
+}
+
+void ReplacementEngine::apply_literals(const pass &literal_pass,
+                                       const string_view text, string &out)
+{
+    out.reserve(text.size());
+    size_t pos{0};
+    size_t copied{0};
+    while (pos < text.size())
+    {
+        const auto index{literal_pass.trie.match(text.substr(pos))};
+        if (!index)
+        {
+            ++pos;
+            continue;
+        }
+
+        const auto &literal{literal_pass.literals[*index]};
+        out.append(text.substr(copied, pos - copied));
+        out.append(literal.second);
+        pos += literal.first.size();
+        copied = pos;
+    }
+    out.append(text.substr(copied));
+}
+} // namespace mastorss
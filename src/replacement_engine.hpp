@@ -0,0 +1,89 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_REPLACEMENT_ENGINE_HPP
+#define MASTORSS_REPLACEMENT_ENGINE_HPP
+
+#include "prefix_trie.hpp"
+
+#include <boost/regex.hpp>
+
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mastorss
+{
+using boost::regex;
+using std::list;
+using std::optional;
+using std::pair;
+using std::string;
+using std::string_view;
+using std::vector;
+
+/*!
+ *  @brief  Applies a list of regular expressions and replacements.
+ *
+ *  The result is the same as applying every replacement with
+ *  boost::regex_replace, in order. Patterns and replacements without special
+ *  characters are replaced literally. Consecutive literal replacements that
+ *  can not interfere with each other are applied together, in one pass over
+ *  the text.
+ *
+ *  @since  0.14.0
+ */
+class ReplacementEngine
+{
+public:
+    //! Construct without replacements. @since  0.14.0
+    ReplacementEngine() = default;
+
+    /*!
+     *  @brief  Compile the replacements.
+     *
+     *  Throws ConfigException if a pattern is invalid. `setting` is used in
+     *  the error message.
+     *
+     *  @since  0.14.0
+     */
+    ReplacementEngine(const list<pair<string, string>> &replacements,
+                      const string &setting);
+
+    //! Apply all replacements. @since  0.14.0
+    [[nodiscard]] string apply(string text) const;
+
+private:
+    //! One pass over the text.
+    struct pass
+    {
+        optional<regex> pattern;                //!< Not literal.
+        string format;                          //!< Replacement for #pattern.
+        vector<pair<string, string>> literals;  //!< Search and replacement.
+        PrefixTrie trie;                        //!< Finds the #literals.
+    };
+
+    vector<pass> _passes;
+
+    static void apply_literals(const pass &literal_pass, string_view text,
+                               string &out);
+};
+} // namespace mastorss
+
+#endif // MASTORSS_REPLACEMENT_ENGINE_HPP
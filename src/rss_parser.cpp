@@ -0,0 +1,421 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rss_parser.hpp"
+
+#include "exceptions.hpp"
+
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace mastorss
+{
+using std::max;
+using std::move;
+
+RSSParser::RSSParser(item_handler handler)
+    : _handler{move(handler)}
+{}
+
+bool RSSParser::feed(const string_view chunk)
+{
+    if (_stopped)
+    {
+        return false;
+    }
+    _buffer.append(chunk);
+
+    while (!_stopped)
+    {
+        // Continue incomplete markup or search for the next.
+        const size_t pos_lt{(_pos < _buffer.size() && _buffer[_pos] == '<')
+                                ? _pos
+                                : _buffer.find('<', max(_pos, _resume))};
+        if (pos_lt == string::npos)
+        {
+            _resume = _buffer.size();
+            break;
+        }
+        if (pos_lt > _pos)
+        {
+            add_text(string_view(_buffer).substr(_pos, pos_lt - _pos), true);
+            _pos = pos_lt;
+            _resume = pos_lt;
+        }
+
+        const size_t end{parse_markup()};
+        if (end == string::npos)
+        {
+            break;
+        }
+        _pos = end;
+        _resume = end;
+    }
+
+    // Only keep what is not parsed yet.
+    _buffer.erase(0, _pos);
+    _resume = (_resume > _pos) ? _resume - _pos : 0;
+    _pos = 0;
+
+    return !_stopped;
+}
+
+void RSSParser::finish()
+{
+    if (_stopped)
+    {
+        return;
+    }
+    if (!_rss)
+    {
+        throw ParseException{"Could not detect type of feed."};
+    }
+    if (!_path.empty()
+        || _buffer.find_first_not_of(" \t\r\n") != string::npos)
+    {
+        throw ParseException{"Feed is incomplete."};
+    }
+}
+
+size_t RSSParser::parse_markup()
+{
+    constexpr string_view comment{"<!--"};
+    constexpr string_view cdata{"<![CDATA["};
+    const string_view rest{string_view(_buffer).substr(_pos)};
+
+    // Returns the position after the terminator or string::npos.
+    const auto find_end{[this](const size_t offset,
+                               const string_view terminator)
+    {
+        // Don't search again what was searched in the previous chunk.
+        const size_t overlap{terminator.size() - 1};
+        const size_t from{max(_pos + offset,
+                              (_resume > overlap) ? _resume - overlap : 0)};
+        const size_t pos{_buffer.find(terminator, from)};
+        if (pos == string::npos)
+        {
+            _resume = _buffer.size();
+            return string::npos;
+        }
+        return pos + terminator.size();
+    }};
+
+    // Wait until we know what kind of markup this is.
+    if ((rest.size() < comment.size()
+         && comment.substr(0, rest.size()) == rest)
+        || (rest.size() < cdata.size() && cdata.substr(0, rest.size()) == rest))
+    {
+        return string::npos;
+    }
+
+    if (rest.substr(0, comment.size()) == comment)
+    {
+        return find_end(comment.size(), "-->");
+    }
+    if (rest.substr(0, cdata.size()) == cdata)
+    {
+        const size_t end{find_end(cdata.size(), "]]>")};
+        if (end != string::npos)
+        {
+            add_text(rest.substr(cdata.size(), end - _pos - cdata.size() - 3),
+                     false);
+        }
+        return end;
+    }
+    if (rest[1] == '?') // Processing instruction.
+    {
+        return find_end(2, "?>");
+    }
+    if (rest[1] == '!') // Document type declaration.
+    {
+        size_t pos{rest.find_first_of("[>", 2)};
+        if (pos != string::npos && rest[pos] == '[')
+        {
+            pos = rest.find(']', pos);
+            if (pos != string::npos)
+            {
+                pos = rest.find('>', pos);
+            }
+        }
+        return (pos == string::npos) ? pos : _pos + pos + 1;
+    }
+
+    // Element, '>' may appear in quoted attribute values.
+    char quote{'\0'};
+    for (size_t pos{1}; pos < rest.size(); ++pos)
+    {
+        const char c{rest[pos]};
+        if (quote != '\0')
+        {
+            if (c == quote)
+            {
+                quote = '\0';
+            }
+        }
+        else if (c == '"' || c == '\'')
+        {
+            quote = c;
+        }
+        else if (c == '>')
+        {
+            const string_view tag{rest.substr(1, pos - 1)};
+            if (!tag.empty() && tag[0] == '/')
+            {
+                close_element(tag_name(tag.substr(1)));
+            }
+            else
+            {
+                open_element(tag);
+                if (!tag.empty() && tag.back() == '/')
+                {
+                    close_element(tag_name(tag));
+                }
+            }
+            return _pos + pos + 1;
+        }
+    }
+
+    return string::npos;
+}
+
+void RSSParser::open_element(const string_view tag)
+{
+    const string_view name{tag_name(tag)};
+    if (name.empty())
+    {
+        throw ParseException{"Malformed feed: Element without name."};
+    }
+
+    if (_path.empty())
+    {
+        if (name != "rss")
+        {
+            throw ParseException{"Could not detect type of feed."};
+        }
+        BOOST_LOG_TRIVIAL(debug) << "RSS detected.";
+        _rss = true;
+    }
+    else if (_path.size() == 2 && _path[1] == "channel")
+    {
+        // The namespace prefix of sy: is not fixed.
+        const string_view local{name.substr(name.find(':') + 1)};
+        if (name == "item")
+        {
+            _item.emplace();
+        }
+        else if (name == "ttl")
+        {
+            set_element(_channel.ttl);
+        }
+        else if (local == "updatePeriod")
+        {
+            set_element(_channel.update_period);
+        }
+        else if (local == "updateFrequency")
+        {
+            set_element(_channel.update_frequency);
+        }
+    }
+    else if (_path.size() == 3 && _item)
+    {
+        if (name == "description")
+        {
+            set_element(_item->description);
+        }
+        else if (name == "guid")
+        {
+            set_element(_item->guid);
+        }
+        else if (name == "link")
+        {
+            set_element(_item->link);
+        }
+        else if (name == "title")
+        {
+            set_element(_item->title);
+        }
+    }
+
+    _path.emplace_back(name);
+}
+
+void RSSParser::close_element(const string_view name)
+{
+    if (_path.empty() || _path.back() != name)
+    {
+        throw ParseException{"Malformed feed: Unexpected </" + string(name)
+                             + ">."};
+    }
+    _path.pop_back();
+
+    if (_path.size() + 1 == _element_depth)
+    {
+        _element = nullptr;
+    }
+    else if (_path.size() == 2 && _item && name == "item")
+    {
+        if (!_handler(*_item))
+        {
+            _stopped = true;
+        }
+        _item.reset();
+    }
+}
+
+void RSSParser::set_element(optional<string> &element)
+{
+    if (!element.has_value())
+    {
+        element.emplace();
+        _element = &element;
+        _element_depth = _path.size() + 1;
+    }
+}
+
+void RSSParser::add_text(const string_view text, const bool decode)
+{
+    if (_element == nullptr || _path.size() != _element_depth)
+    {
+        return;
+    }
+
+    if (decode)
+    {
+        decode_entities(text, **_element);
+    }
+    else
+    {
+        (*_element)->append(text);
+    }
+}
+
+string_view RSSParser::tag_name(const string_view tag)
+{
+    return tag.substr(0, tag.find_first_of(" \t\r\n/"));
+}
+
+void RSSParser::decode_entities(const string_view text, string &out)
+{
+    out.reserve(out.size() + text.size());
+
+    size_t pos{0};
+    while (pos < text.size())
+    {
+        const size_t pos_amp{text.find('&', pos)};
+        out.append(text.substr(pos, pos_amp - pos));
+        if (pos_amp == string::npos)
+        {
+            break;
+        }
+
+        const size_t pos_semicolon{text.find(';', pos_amp)};
+        if (pos_semicolon == string::npos)
+        {
+            out.append(text.substr(pos_amp));
+            break;
+        }
+
+        const string_view name{
+            text.substr(pos_amp + 1, pos_semicolon - pos_amp - 1)};
+        pos = pos_semicolon + 1;
+        if (name == "lt")
+        {
+            out += '<';
+        }
+        else if (name == "gt")
+        {
+            out += '>';
+        }
+        else if (name == "amp")
+        {
+            out += '&';
+        }
+        else if (name == "quot")
+        {
+            out += '"';
+        }
+        else if (name == "apos")
+        {
+            out += '\'';
+        }
+        else if (name.size() > 1 && name[0] == '#')
+        {
+            const bool hex{name[1] == 'x' || name[1] == 'X'};
+            const string_view digits{name.substr(hex ? 2 : 1)};
+            std::uint32_t cp{0};
+            bool valid{!digits.empty() && digits.size() <= 8};
+            for (const char c : digits)
+            {
+                std::uint32_t digit{0};
+                if (c >= '0' && c <= '9')
+                {
+                    digit = static_cast<std::uint32_t>(c - '0');
+                }
+                else if (hex && c >= 'a' && c <= 'f')
+                {
+                    digit = static_cast<std::uint32_t>(c - 'a' + 10);
+                }
+                else if (hex && c >= 'A' && c <= 'F')
+                {
+                    digit = static_cast<std::uint32_t>(c - 'A' + 10);
+                }
+                else
+                {
+                    valid = false;
+                    break;
+                }
+                cp = cp * (hex ? 16U : 10U) + digit;
+            }
+            if (!valid || cp > 0x10FFFF)
+            {
+                out.append(text.substr(pos_amp, pos - pos_amp));
+                continue;
+            }
+
+            // Encode as UTF-8.
+            if (cp < 0x80)
+            {
+                out += static_cast<char>(cp);
+            }
+            else if (cp < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (cp >> 6));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (cp >> 12));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (cp >> 18));
+                out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+        else // Unknown entity, keep it.
+        {
+            out.append(text.substr(pos_amp, pos - pos_amp));
+        }
+    }
+}
+} // namespace mastorss
@@ -0,0 +1,149 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_RSS_PARSER_HPP
+#define MASTORSS_RSS_PARSER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastorss
+{
+using std::optional;
+using std::string;
+using std::string_view;
+using std::vector;
+
+/*!
+ *  @brief  Streaming RSS parser.
+ *
+ *  The document can be fed in chunks of any size. Each `<item>` is handed to
+ *  the handler as soon as it is closed; only the item that is currently
+ *  parsed is kept in memory.
+ *
+ *  Like boost::property_tree, the text of an element is the concatenation of
+ *  its text and CDATA sections, without the text of child elements. The 5
+ *  predefined entities and numeric character references are decoded.
+ *
+ *  @since  0.14.0
+ */
+class RSSParser
+{
+public:
+    /*!
+     *  @brief  The raw elements of an item that mastorss uses.
+     *
+     *  Elements that are not present are empty optionals. If an element occurs
+     *  more than once, the first one is used.
+     *
+     *  @since  0.14.0
+     */
+    struct item
+    {
+        optional<string> description;
+        optional<string> guid;
+        optional<string> link;
+        optional<string> title;
+    };
+
+    /*!
+     *  @brief  The elements of the channel that tell how often it changes.
+     *
+     *  Only elements before the point where parsing stopped are known.
+     *
+     *  @since  0.14.0
+     */
+    struct channel
+    {
+        optional<string> ttl;
+        optional<string> update_period;    //!< `<sy:updatePeriod>`
+        optional<string> update_frequency; //!< `<sy:updateFrequency>`
+    };
+
+    //! Called for every item. Return `false` to stop parsing.
+    using item_handler = std::function<bool(item &rssitem)>;
+
+    explicit RSSParser(item_handler handler);
+
+    /*!
+     *  @brief  Parse the next part of the document.
+     *
+     *  May throw ParseException.
+     *
+     *  @return `false` if the handler stopped parsing.
+     *
+     *  @since  0.14.0
+     */
+    bool feed(string_view chunk);
+
+    /*!
+     *  @brief  Signal the end of the document.
+     *
+     *  Throws ParseException if the document is not RSS or incomplete, unless
+     *  the handler stopped parsing.
+     *
+     *  @since  0.14.0
+     */
+    void finish();
+
+    //! Returns `true` if the handler stopped parsing. @since  0.14.0
+    [[nodiscard]] inline bool stopped() const
+    {
+        return _stopped;
+    }
+
+    //! Returns the channel elements parsed so far. @since  0.14.0
+    [[nodiscard]] inline const channel &get_channel() const
+    {
+        return _channel;
+    }
+
+private:
+    item_handler _handler;
+    string _buffer;
+    size_t _pos{0};
+    size_t _resume{0};
+    vector<string> _path;
+    bool _rss{false};
+    bool _stopped{false};
+    optional<item> _item;
+    channel _channel;
+    optional<string> *_element{nullptr};
+    size_t _element_depth{0}; //!< Size of #_path inside #_element.
+
+    /*!
+     *  @brief  Parse the markup at #_pos.
+     *
+     *  @return Position after the markup or string::npos if it is incomplete.
+     *
+     *  @since  0.14.0
+     */
+    size_t parse_markup();
+    void open_element(string_view tag);
+    void close_element(string_view name);
+    //! Collect the text of the element that is opened into `element`.
+    void set_element(optional<string> &element);
+    void add_text(string_view text, bool decode);
+    [[nodiscard]] static string_view tag_name(string_view tag);
+    static void decode_entities(string_view text, string &out);
+};
+} // namespace mastorss
+
+#endif // MASTORSS_RSS_PARSER_HPP
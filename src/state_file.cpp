@@ -0,0 +1,173 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "state_file.hpp"
+
+#include "exceptions.hpp"
+
+#include <boost/log/trivial.hpp>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <string>
+
+namespace mastorss
+{
+using std::string;
+
+namespace
+{
+//! Read the whole file.
+Json::Value read_json(const int fd, const fs::path &path)
+{
+    string data;
+    char buffer[512]; // NOLINT(modernize-avoid-c-arrays)
+    ssize_t size{0};
+    while ((size = ::read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        data.append(buffer, static_cast<size_t>(size));
+    }
+
+    Json::Value json;
+    try
+    {
+        std::istringstream stream{data};
+        if (data.empty() || !(stream >> json) || !json.isObject())
+        {
+            json = Json::objectValue;
+        }
+    }
+    catch (const std::exception &)
+    {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring invalid " << path << '.';
+        json = Json::objectValue;
+    }
+
+    return json;
+}
+/*!
+ *  @brief  Replace the file with `json`.
+ *
+ *  The JSON is written to `<path>.new`, synced and renamed over the file, so
+ *  that the old file stays intact if writing fails.
+ */
+void write_json(const fs::path &path, const Json::Value &json)
+{
+    const fs::path tmp{path.string() + ".new"};
+    const int fd{
+        ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+    if (fd < 0)
+    {
+        throw FileException{"Could not open " + tmp.string() + ": "
+                            + std::strerror(errno)};
+    }
+
+    const string data{json.toStyledString()};
+    size_t written{0};
+    while (written < data.size())
+    {
+        const ssize_t size{
+            ::write(fd, data.data() + written, data.size() - written)};
+        if (size < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (size <= 0)
+        {
+            break;
+        }
+        written += static_cast<size_t>(size);
+    }
+    const bool synced{written == data.size() && ::fsync(fd) == 0};
+    if (::close(fd) != 0 || !synced
+        || ::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        const string error{std::strerror(errno)};
+        ::unlink(tmp.c_str());
+        throw FileException{"Could not write " + path.string() + ": "
+                            + error};
+    }
+}
+} // namespace
+
+void modify_state_file(const fs::path &path,
+                       const std::function<void(Json::Value &)> &change)
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    // The file itself is replaced, so the lock is taken on another file.
+    const fs::path lockpath{path.string() + ".lock"};
+    const int lockfd{
+        ::open(lockpath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)};
+    if (lockfd < 0)
+    {
+        BOOST_LOG_TRIVIAL(warning) << "Could not open " << lockpath << ": "
+                                   << std::strerror(errno);
+        return;
+    }
+
+    try
+    {
+        // The lock is released when the file is closed.
+        if (::flock(lockfd, LOCK_EX) != 0)
+        {
+            throw FileException{"Could not lock " + lockpath.string() + "."};
+        }
+
+        const Json::Value old{read_state_file(path)};
+        Json::Value json{old};
+        change(json);
+        if (json != old)
+        {
+            write_json(path, json);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        BOOST_LOG_TRIVIAL(warning) << e.what();
+    }
+    ::close(lockfd);
+}
+
+Json::Value read_state_file(const fs::path &path)
+{
+    // Files are replaced atomically, so no lock is needed to read them.
+    const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fd < 0)
+    {
+        if (errno != ENOENT)
+        {
+            BOOST_LOG_TRIVIAL(warning) << "Could not open " << path << ": "
+                                       << std::strerror(errno);
+        }
+        return Json::objectValue;
+    }
+
+    Json::Value json{read_json(fd, path)};
+    ::close(fd);
+
+    return json;
+}
+} // namespace mastorss
@@ -0,0 +1,56 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_STATE_FILE_HPP
+#define MASTORSS_STATE_FILE_HPP
+
+#include <boost/filesystem.hpp>
+#include <json/json.h>
+
+#include <functional>
+
+namespace mastorss
+{
+namespace fs = boost::filesystem;
+
+/*!
+ *  @brief  Lock a small JSON file, read it, change it and write it back.
+ *
+ *  `<path>.lock` is locked with flock(2) while the file is changed, so that
+ *  several processes can share it. The new content is written to
+ *  `<path>.new`, synced and renamed over the file, which is never left empty
+ *  or partially written. Nothing is written if `change` didn't change the
+ *  JSON. A missing or invalid file is passed to `change` as an empty object.
+ *  Problems with the file are logged and never thrown. Nothing is done if
+ *  `path` is empty.
+ *
+ *  @since  0.14.0
+ */
+void modify_state_file(const fs::path &path,
+                       const std::function<void(Json::Value &)> &change);
+
+/*!
+ *  @brief  Read a small JSON file that is changed with modify_state_file().
+ *
+ *  A missing or invalid file is returned as an empty object. Problems with
+ *  the file are logged and never thrown.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] Json::Value read_state_file(const fs::path &path);
+} // namespace mastorss
+
+#endif // MASTORSS_STATE_FILE_HPP
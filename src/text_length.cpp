@@ -0,0 +1,212 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "text_length.hpp"
+
+#include <bitset>
+#include <optional>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+namespace mastorss
+{
+using std::optional;
+
+namespace
+{
+//! Returns `true` if the byte is not a continuation byte (10xxxxxx).
+inline bool starts_code_point(const char c)
+{
+    return (static_cast<unsigned char>(c) & 0xC0U) != 0x80U;
+}
+
+inline bool is_ascii_alnum(const char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z')
+           || (c >= 'a' && c <= 'z');
+}
+
+/*!
+ *  @brief  Returns `true` if the host has a top level domain.
+ *
+ *  Mastodon only counts URLs with a valid TLD as URLs.
+ */
+bool valid_host(const string_view host)
+{
+    const size_t pos_dot{host.rfind('.')};
+    if (pos_dot == string_view::npos || pos_dot == 0)
+    {
+        return false;
+    }
+
+    const string_view tld{host.substr(pos_dot + 1)};
+    if (tld.substr(0, 4) == "xn--")
+    {
+        return tld.size() > 4;
+    }
+    if (tld.size() < 2)
+    {
+        return false;
+    }
+    for (const char c : tld)
+    {
+        if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! A URL in a text.
+struct url
+{
+    size_t begin;
+    size_t end;
+};
+
+/*!
+ *  @brief  Find the next URL at or after `pos`.
+ *
+ *  Trailing punctuation is not part of the URL, like in Mastodon.
+ */
+optional<url> find_url(const string_view text, size_t pos)
+{
+    constexpr string_view whitespace{" \t\r\n\f\v<>\""};
+    constexpr string_view trailing{".,:;!?'()[]{}*"};
+
+    while ((pos = text.find("http", pos)) != string_view::npos)
+    {
+        const size_t begin{pos};
+        ++pos;
+        if (begin > 0 && (is_ascii_alnum(text[begin - 1])
+                          || text[begin - 1] == '/'))
+        {
+            continue;
+        }
+
+        string_view rest{text.substr(begin + 4)};
+        if (rest.substr(0, 1) == "s")
+        {
+            rest.remove_prefix(1);
+        }
+        if (rest.substr(0, 3) != "://")
+        {
+            continue;
+        }
+        rest.remove_prefix(3);
+
+        size_t len{rest.find_first_of(whitespace)};
+        if (len == string_view::npos)
+        {
+            len = rest.size();
+        }
+        while (len > 0 && trailing.find(rest[len - 1]) != string_view::npos)
+        {
+            --len;
+        }
+        rest = rest.substr(0, len);
+        if (!valid_host(rest.substr(0, rest.find_first_of("/?#:"))))
+        {
+            continue;
+        }
+
+        return url{begin, static_cast<size_t>(rest.data() - text.data())
+                              + rest.size()};
+    }
+
+    return {};
+}
+} // namespace
+
+size_t count_code_points(const string_view text)
+{
+    size_t count{0};
+    size_t pos{0};
+
+#if defined(__SSE2__)
+    // Bytes greater than 0xBF as signed char start a code point.
+    constexpr char last_continuation{static_cast<char>(0xBF)};
+    const __m128i threshold{_mm_set1_epi8(last_continuation)};
+    for (; pos + 16 <= text.size(); pos += 16)
+    {
+        const __m128i chunk{_mm_loadu_si128(
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            reinterpret_cast<const __m128i *>(text.data() + pos))};
+        const auto mask{static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpgt_epi8(chunk, threshold)))};
+        count += std::bitset<16>{mask}.count();
+    }
+#endif
+
+    for (; pos < text.size(); ++pos)
+    {
+        if (starts_code_point(text[pos]))
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+size_t status_length(const string_view text)
+{
+    size_t length{0};
+    size_t pos{0};
+    while (const auto next{find_url(text, pos)})
+    {
+        length += count_code_points(text.substr(pos, next->begin - pos))
+                  + url_length;
+        pos = next->end;
+    }
+
+    return length + count_code_points(text.substr(pos));
+}
+
+size_t fit_status(const string_view text, const size_t max_length)
+{
+    size_t length{0};
+    size_t pos{0};
+    while (pos < text.size())
+    {
+        const auto next{find_url(text, pos)};
+        const size_t end{next ? next->begin : text.size()};
+        for (; pos < end; ++pos)
+        {
+            if (starts_code_point(text[pos]) && length++ == max_length)
+            {
+                return pos;
+            }
+        }
+        if (!next)
+        {
+            break;
+        }
+
+        if (length + url_length > max_length)
+        {
+            return pos;
+        }
+        length += url_length;
+        pos = next->end;
+    }
+
+    return text.size();
+}
+} // namespace mastorss
@@ -0,0 +1,66 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_TEXT_LENGTH_HPP
+#define MASTORSS_TEXT_LENGTH_HPP
+
+#include <cstddef>
+#include <string_view>
+
+namespace mastorss
+{
+using std::string_view;
+
+/*!
+ *  @brief  Number of URLs count as in a status.
+ *
+ *  @since  0.14.0
+ */
+constexpr size_t url_length{23};
+
+/*!
+ *  @brief  Count the code points of UTF-8 encoded text.
+ *
+ *  Uses SSE2 if it is available.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] size_t count_code_points(string_view text);
+
+/*!
+ *  @brief  The length of a status like Mastodon counts it.
+ *
+ *  Every URL counts as #url_length characters. Mastodon counts grapheme
+ *  clusters, this counts code points, which are never fewer.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] size_t status_length(string_view text);
+
+/*!
+ *  @brief  Find the longest beginning of the text that is not longer than
+ *          `max_length`.
+ *
+ *  Never cuts a code point or a URL in half.
+ *
+ *  @return The size of the beginning in bytes.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] size_t fit_status(string_view text, size_t max_length);
+} // namespace mastorss
+
+#endif // MASTORSS_TEXT_LENGTH_HPP
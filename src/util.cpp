@@ -0,0 +1,64 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "util.hpp"
+
+#include <chrono>
+#include <string>
+
+namespace mastorss
+{
+using std::int64_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::chrono::system_clock;
+
+uint64_t fnv1a_64(const string_view data, uint64_t hash)
+{
+    constexpr uint64_t prime{1099511628211ULL};
+    for (const char c : data)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * prime;
+    }
+    return hash;
+}
+
+uint32_t fnv1a_32(const string_view data, uint32_t hash)
+{
+    constexpr uint32_t prime{16777619U};
+    for (const char c : data)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * prime;
+    }
+    return hash;
+}
+
+optional<int64_t> parse_integer(const string_view value)
+{
+    if (value.empty() || value.size() > 18
+        || value.find_first_not_of("0123456789") != string_view::npos)
+    {
+        return {};
+    }
+    return std::stoll(std::string(value));
+}
+
+int64_t unix_now()
+{
+    return system_clock::to_time_t(system_clock::now());
+}
+} // namespace mastorss
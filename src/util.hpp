@@ -0,0 +1,64 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MASTORSS_UTIL_HPP
+#define MASTORSS_UTIL_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace mastorss
+{
+using std::optional;
+using std::string_view;
+
+//! Offset basis of the 64 bit FNV-1a hash. @since  0.14.0
+constexpr std::uint64_t fnv1a_64_basis{14695981039346656037ULL};
+
+//! Offset basis of the 32 bit FNV-1a hash. @since  0.14.0
+constexpr std::uint32_t fnv1a_32_basis{2166136261U};
+
+/*!
+ *  @brief  64 bit FNV-1a hash, stable across platforms and versions.
+ *
+ *  Pass the hash of the previous part as `hash` to hash several parts.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] std::uint64_t fnv1a_64(string_view data,
+                                     std::uint64_t hash = fnv1a_64_basis);
+
+//! 32 bit variant of fnv1a_64(). @since  0.14.0
+[[nodiscard]] std::uint32_t fnv1a_32(string_view data,
+                                     std::uint32_t hash = fnv1a_32_basis);
+
+/*!
+ *  @brief  Parse a non-negative decimal integer.
+ *
+ *  @return The number, or an empty optional if `value` contains anything
+ *          else or has more than 18 digits.
+ *
+ *  @since  0.14.0
+ */
+[[nodiscard]] optional<std::int64_t> parse_integer(string_view value);
+
+//! Returns the current time in seconds since the epoch. @since  0.14.0
+[[nodiscard]] std::int64_t unix_now();
+} // namespace mastorss
+
+#endif // MASTORSS_UTIL_HPP
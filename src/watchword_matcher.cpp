@@ -0,0 +1,486 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "watchword_matcher.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <queue>
+#include <utility>
+
+namespace mastorss
+{
+namespace
+{
+constexpr char magic[]{"MRSSWWAC"}; // NOLINT(modernize-avoid-c-arrays)
+constexpr uint32_t version{2};
+constexpr uint32_t max_nodes{1U << 24U};
+
+// Decodes the code point at pos and advances pos. Invalid bytes are returned
+// as values that are not code points.
+char32_t next_codepoint(const string_view text, size_t &pos)
+{
+    const auto byte{[&](const size_t i)
+                    { return static_cast<unsigned char>(text[i]); }};
+    const unsigned char first{byte(pos)};
+    const char32_t invalid{0x110000U + first};
+
+    size_t length{1};
+    char32_t cp{first};
+    if (first >= 0xF0 && first < 0xF8)
+    {
+        length = 4;
+        cp = first & 0x07U;
+    }
+    else if (first >= 0xE0)
+    {
+        length = 3;
+        cp = first & 0x0FU;
+    }
+    else if (first >= 0xC0)
+    {
+        length = 2;
+        cp = first & 0x1FU;
+    }
+    else if (first >= 0x80)
+    {
+        ++pos;
+        return invalid;
+    }
+    if (first >= 0xF8 || pos + length > text.size())
+    {
+        ++pos;
+        return invalid;
+    }
+
+    for (size_t i{1}; i < length; ++i)
+    {
+        if ((byte(pos + i) & 0xC0U) != 0x80)
+        {
+            ++pos;
+            return invalid;
+        }
+        cp = (cp << 6U) | (byte(pos + i) & 0x3FU);
+    }
+    pos += length;
+    return cp;
+}
+
+// Simple case folding for Latin, Greek and Cyrillic.
+char32_t fold(const char32_t cp)
+{
+    if ((cp >= 'A' && cp <= 'Z') || (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7)
+        || (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2)
+        || (cp >= 0x410 && cp <= 0x42F))
+    {
+        return cp + 0x20;
+    }
+    if (cp >= 0x400 && cp <= 0x40F)
+    {
+        return cp + 0x50;
+    }
+    if ((cp >= 0x100 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177))
+    {
+        return cp | 1U;
+    }
+    if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E))
+    {
+        return ((cp & 1U) == 1) ? cp + 1 : cp;
+    }
+    switch (cp)
+    {
+    case 0x178: // LATIN CAPITAL LETTER Y WITH DIAERESIS
+        return 0xFF;
+    case 0x17F: // LATIN SMALL LETTER LONG S
+        return 's';
+    case 0x386: // GREEK CAPITAL LETTER ALPHA WITH TONOS
+        return 0x3AC;
+    case 0x388: // GREEK CAPITAL LETTER EPSILON WITH TONOS
+    case 0x389:
+    case 0x38A:
+        return cp + 0x25;
+    case 0x38C: // GREEK CAPITAL LETTER OMICRON WITH TONOS
+        return 0x3CC;
+    case 0x38E: // GREEK CAPITAL LETTER UPSILON WITH TONOS
+    case 0x38F:
+        return cp + 0x3F;
+    case 0x3C2: // GREEK SMALL LETTER FINAL SIGMA
+        return 0x3C3;
+    case 0x1E9E: // LATIN CAPITAL LETTER SHARP S
+        return 0xDF;
+    case 0x212A: // KELVIN SIGN
+        return 'k';
+    case 0x212B: // ANGSTROM SIGN
+        return 0xE5;
+    default:
+        return cp;
+    }
+}
+
+bool is_space(const char32_t cp)
+{
+    return cp == ' ' || (cp >= '\t' && cp <= '\r') || cp == 0x200B;
+}
+
+bool is_punct(const char32_t cp)
+{
+    return (cp >= '!' && cp <= '/') || (cp >= ':' && cp <= '@')
+           || (cp >= '[' && cp <= '`') || (cp >= '{' && cp <= '~');
+}
+} // namespace
+
+WatchwordMatcher::WatchwordMatcher()
+    : WatchwordMatcher(list<string>{})
+{}
+
+WatchwordMatcher::WatchwordMatcher(const list<string> &watchwords)
+{
+    // Build the trie with temporary maps, then flatten it.
+    vector<std::map<char32_t, uint32_t>> children(1);
+    vector<uint32_t> output(1, 0);
+    vector<uint32_t> lengths;
+    for (const auto &watchword : watchwords)
+    {
+        uint32_t node{0};
+        uint32_t length{0};
+        size_t pos{0};
+        while (pos < watchword.size())
+        {
+            const char32_t cp{fold(next_codepoint(watchword, pos))};
+            const auto it{children[node].find(cp)};
+            if (it != children[node].end())
+            {
+                node = it->second;
+            }
+            else
+            {
+                const auto next{static_cast<uint32_t>(children.size())};
+                children[node].emplace(cp, next);
+                children.emplace_back();
+                output.push_back(0);
+                node = next;
+            }
+            ++length;
+        }
+        if (length == 0 || output[node] != 0)
+        {
+            continue; // Empty or duplicate.
+        }
+        lengths.push_back(length);
+        output[node] = static_cast<uint32_t>(lengths.size());
+    }
+
+    const auto child_of{[&children](const uint32_t node, const char32_t cp)
+                        {
+                            const auto it{children[node].find(cp)};
+                            return (it != children[node].end()) ? it->second
+                                                                : 0;
+                        }};
+
+    // Breadth-first, so the fail links of shallower nodes are known.
+    vector<uint32_t> fail(children.size(), 0);
+    vector<uint32_t> output_link(children.size(), 0);
+    std::queue<uint32_t> queue;
+    for (const auto &entry : children[0])
+    {
+        queue.push(entry.second);
+    }
+    while (!queue.empty())
+    {
+        const uint32_t node{queue.front()};
+        queue.pop();
+        for (const auto &[cp, target] : children[node])
+        {
+            uint32_t link{fail[node]};
+            while (link != 0 && child_of(link, cp) == 0)
+            {
+                link = fail[link];
+            }
+            fail[target] = child_of(link, cp);
+            output_link[target] = (output[fail[target]] != 0)
+                                      ? fail[target]
+                                      : output_link[fail[target]];
+            queue.push(target);
+        }
+    }
+
+    // Assemble the block.
+    header hdr{};
+    std::memcpy(hdr.magic, magic, sizeof(hdr.magic));
+    hdr.version = version;
+    hdr.nodes = static_cast<uint32_t>(children.size());
+    hdr.watchwords = static_cast<uint32_t>(lengths.size());
+    vector<uint32_t> first_edge;
+    vector<edge> edges;
+    first_edge.reserve(children.size() + 1);
+    for (const auto &node_children : children)
+    {
+        first_edge.push_back(static_cast<uint32_t>(edges.size()));
+        for (const auto &[cp, target] : node_children)
+        {
+            edges.push_back({cp, target});
+        }
+    }
+    first_edge.push_back(static_cast<uint32_t>(edges.size()));
+    hdr.edges = static_cast<uint32_t>(edges.size());
+
+    _memory.resize((block_size(hdr) + sizeof(uint64_t) - 1)
+                   / sizeof(uint64_t));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    auto *out{reinterpret_cast<char *>(_memory.data())};
+    const auto append{[&out](const void *data, const size_t size)
+                      {
+                          if (size > 0)
+                          {
+                              std::memcpy(out, data, size);
+                              out += size; // NOLINT(*-pointer-arithmetic)
+                          }
+                      }};
+    append(&hdr, sizeof(hdr));
+    append(first_edge.data(), first_edge.size() * sizeof(uint32_t));
+    append(edges.data(), edges.size() * sizeof(edge));
+    append(fail.data(), fail.size() * sizeof(uint32_t));
+    append(output.data(), output.size() * sizeof(uint32_t));
+    append(output_link.data(), output_link.size() * sizeof(uint32_t));
+    append(lengths.data(), lengths.size() * sizeof(uint32_t));
+    attach(_memory.data());
+}
+
+optional<WatchwordMatcher> WatchwordMatcher::load(const fs::path &path,
+                                                  const source &from)
+{
+    namespace bip = boost::interprocess;
+
+    WatchwordMatcher matcher;
+    try
+    {
+        const bip::file_mapping file{path.c_str(), bip::read_only};
+        bip::mapped_region region{file, bip::read_only};
+
+        const auto *hdr{static_cast<const header *>(region.get_address())};
+        if (region.get_size() < sizeof(header)
+            || std::memcmp(hdr->magic, magic, sizeof(hdr->magic)) != 0
+            || hdr->version != version || hdr->source_size != from.size
+            || hdr->source_hash != from.hash || hdr->nodes == 0
+            || hdr->nodes > max_nodes || hdr->edges >= hdr->nodes
+            || hdr->watchwords >= hdr->nodes
+            || region.get_size() != block_size(*hdr))
+        {
+            return {};
+        }
+
+        matcher._region = std::move(region);
+        matcher._memory = {};
+        matcher.attach(matcher._region.get_address());
+    }
+    catch (const bip::interprocess_exception &)
+    {
+        return {};
+    }
+
+    if (!matcher.valid())
+    {
+        return {};
+    }
+    return matcher;
+}
+
+bool WatchwordMatcher::save(const fs::path &path, const source &from) const
+{
+    header hdr{*_header};
+    hdr.source_size = from.size;
+    hdr.source_hash = from.hash;
+
+    const fs::path tmp{path.string() + ".new"};
+    {
+        std::ofstream file{tmp.c_str(), std::ios::binary | std::ios::trunc};
+        // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+        file.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+        file.write(reinterpret_cast<const char *>(_header + 1),
+                   static_cast<std::streamsize>(block_size(hdr)
+                                                - sizeof(hdr)));
+        // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+        if (!file.good())
+        {
+            return false;
+        }
+    }
+
+    boost::system::error_code error;
+    fs::rename(tmp, path, error);
+    return !error;
+}
+
+string WatchwordMatcher::add_hashtags(const string_view text) const
+{
+    if (empty())
+    {
+        return string{text};
+    }
+
+    struct match
+    {
+        size_t start; // Index of the first code point.
+        size_t end;   // Index after the last code point.
+        uint32_t watchword;
+    };
+    vector<size_t> offsets; // Byte offset of every code point.
+    vector<char32_t> codepoints;
+    vector<match> matches;
+
+    uint32_t node{0};
+    size_t pos{0};
+    while (pos < text.size())
+    {
+        offsets.push_back(pos);
+        const char32_t cp{next_codepoint(text, pos)};
+        codepoints.push_back(cp);
+        node = step(node, fold(cp));
+
+        for (uint32_t out{(_output[node] != 0) ? node : _output_link[node]};
+             out != 0; out = _output_link[out])
+        {
+            const uint32_t watchword{_output[out] - 1};
+            const size_t end{codepoints.size()};
+            const size_t start{end - _lengths[watchword]};
+            if (start == 0 || is_space(codepoints[start - 1]))
+            {
+                matches.push_back({start, end, watchword});
+            }
+        }
+    }
+    offsets.push_back(text.size());
+
+    std::sort(matches.begin(), matches.end(),
+              [](const match &a, const match &b)
+              {
+                  return a.start < b.start
+                         || (a.start == b.start && a.end > b.end);
+              });
+
+    string out;
+    out.reserve(text.size() + matches.size());
+    vector<bool> tagged(_header->watchwords, false);
+    size_t copied{0}; // Bytes of text that are in out.
+    size_t covered{0}; // Code points up to the end of the last hashtag.
+    for (const auto &m : matches)
+    {
+        if (tagged[m.watchword] || m.start < covered
+            || (m.end < codepoints.size() && !is_space(codepoints[m.end])
+                && !is_punct(codepoints[m.end])))
+        {
+            continue;
+        }
+        tagged[m.watchword] = true;
+        covered = m.end;
+
+        out.append(text.substr(copied, offsets[m.start] - copied));
+        out += '#';
+        copied = offsets[m.start];
+    }
+    out.append(text.substr(copied));
+
+    return out;
+}
+
+size_t WatchwordMatcher::block_size(const header &hdr)
+{
+    return sizeof(header) + (hdr.nodes + 1) * sizeof(uint32_t)
+           + hdr.edges * sizeof(edge) + hdr.nodes * 3 * sizeof(uint32_t)
+           + hdr.watchwords * sizeof(uint32_t);
+}
+
+void WatchwordMatcher::attach(const void *data)
+{
+    // The arrays follow each other without padding, see block_size().
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast,
+    //             cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    _header = static_cast<const header *>(data);
+    const uint32_t nodes{_header->nodes};
+    _first_edge = reinterpret_cast<const uint32_t *>(_header + 1);
+    _edges = reinterpret_cast<const edge *>(_first_edge + nodes + 1);
+    _fail = reinterpret_cast<const uint32_t *>(_edges + _header->edges);
+    _output = _fail + nodes;
+    _output_link = _output + nodes;
+    _lengths = _output_link + nodes;
+    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast,
+    //           cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+bool WatchwordMatcher::valid() const
+{
+    const uint32_t nodes{_header->nodes};
+    if (_first_edge[0] != 0 || _first_edge[nodes] != _header->edges)
+    {
+        return false;
+    }
+    for (uint32_t node{0}; node < nodes; ++node)
+    {
+        if (_first_edge[node] > _first_edge[node + 1] || _fail[node] >= nodes
+            || _output[node] > _header->watchwords
+            || _output_link[node] >= nodes)
+        {
+            return false;
+        }
+    }
+    for (uint32_t i{0}; i < _header->watchwords; ++i)
+    {
+        if (_lengths[i] == 0 || _lengths[i] >= nodes)
+        {
+            return false;
+        }
+    }
+    for (uint32_t i{0}; i < _header->edges; ++i)
+    {
+        if (_edges[i].target >= nodes || _edges[i].target == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t WatchwordMatcher::step(uint32_t node, const char32_t codepoint) const
+{
+    while (true)
+    {
+        const uint32_t next{child(node, codepoint)};
+        if (next != 0 || node == 0)
+        {
+            return next;
+        }
+        node = _fail[node];
+    }
+}
+
+uint32_t WatchwordMatcher::child(const uint32_t node,
+                                 const char32_t codepoint) const
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const edge *begin{_edges + _first_edge[node]};
+    const edge *end{_edges + _first_edge[node + 1]};
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const auto it{std::lower_bound(begin, end, codepoint,
+                                   [](const edge &e, const char32_t cp)
+                                   { return e.codepoint < cp; })};
+    return (it != end && it->codepoint == codepoint) ? it->target : 0;
+}
+} // namespace mastorss
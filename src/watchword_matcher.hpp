@@ -0,0 +1,157 @@
+/*  This file is part of mastorss.
+ *  Copyright © 2021 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTORSS_WATCHWORD_MATCHER_HPP
+#define MASTORSS_WATCHWORD_MATCHER_HPP
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastorss
+{
+namespace fs = boost::filesystem;
+using std::list;
+using std::optional;
+using std::string;
+using std::string_view;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+/*!
+ *  @brief  Turns watchwords into hashtags.
+ *
+ *  An Aho-Corasick automaton over case-folded code points, built once from all
+ *  watchwords. The text is scanned once for all of them.
+ *
+ *  A watchword matches if it is preceded by whitespace, U+200B (zero width
+ *  space) or the beginning of the text and followed by whitespace, U+200B,
+ *  ASCII punctuation or the end of the text. Only the first match of every
+ *  watchword is turned into a hashtag. If matches overlap, the one that starts
+ *  first wins, then the longest.
+ *
+ *  The automaton is stored in one block that can be saved to a file and
+ *  memory-mapped again, see save() and load().
+ *
+ *  @since  0.14.0
+ */
+class WatchwordMatcher
+{
+public:
+    //! Construct a matcher without watchwords. @since  0.14.0
+    WatchwordMatcher();
+
+    //! Build the automaton. Watchwords are literal text. @since  0.14.0
+    explicit WatchwordMatcher(const list<string> &watchwords);
+    ~WatchwordMatcher() = default;
+    WatchwordMatcher(const WatchwordMatcher &other) = delete;
+    WatchwordMatcher &operator=(const WatchwordMatcher &other) = delete;
+    WatchwordMatcher(WatchwordMatcher &&other) noexcept = default;
+    WatchwordMatcher &operator=(WatchwordMatcher &&other) noexcept = default;
+
+    /*!
+     *  @brief  Identifies the watchwords a saved automaton was built from.
+     *
+     *  @since  0.14.0
+     */
+    struct source
+    {
+        uint64_t size{0}; //!< Size of the watchwords file.
+        uint64_t hash{0}; //!< FNV-1a hash of the watchwords file.
+    };
+
+    /*!
+     *  @brief  Memory-map a saved automaton.
+     *
+     *  @return An empty optional if the file doesn't exist, is invalid or was
+     *          built from a different source.
+     *
+     *  @since  0.14.0
+     */
+    [[nodiscard]] static optional<WatchwordMatcher>
+    load(const fs::path &path, const source &from);
+
+    /*!
+     *  @brief  Save the automaton, replacing the file atomically.
+     *
+     *  Returns `false` if the file could not be written.
+     *
+     *  @since  0.14.0
+     */
+    bool save(const fs::path &path, const source &from) const;
+
+    //! Prepend `#` to the first match of every watchword. @since  0.14.0
+    [[nodiscard]] string add_hashtags(string_view text) const;
+
+    [[nodiscard]] inline bool empty() const
+    {
+        return _header->watchwords == 0;
+    }
+
+private:
+    struct header
+    {
+        char magic[8]; // NOLINT(modernize-avoid-c-arrays)
+        uint32_t version;
+        uint32_t nodes;
+        uint32_t edges;
+        uint32_t watchwords;
+        uint64_t source_size;
+        uint64_t source_hash;
+    };
+
+    // Node 0 is the root; as a link target it means “none”.
+    struct edge
+    {
+        char32_t codepoint;
+        uint32_t target;
+    };
+
+    // Either _memory or _region holds the block, the pointers point into it.
+    vector<uint64_t> _memory;
+    boost::interprocess::mapped_region _region;
+    const header *_header{nullptr};
+    // Indexed by node. The edges of node n are _edges[_first_edge[n]] up to
+    // _edges[_first_edge[n + 1]], sorted by code point.
+    const uint32_t *_first_edge{nullptr};
+    const edge *_edges{nullptr};
+    const uint32_t *_fail{nullptr};
+    const uint32_t *_output{nullptr};      // Watchword + 1, 0 if none.
+    const uint32_t *_output_link{nullptr}; // Next node in the fail chain with
+                                           // output.
+    // Indexed by watchword: Length in code points.
+    const uint32_t *_lengths{nullptr};
+
+    //! Size of the block in bytes. @since  0.14.0
+    [[nodiscard]] static size_t block_size(const header &hdr);
+    //! Set the pointers into the block at `data`. @since  0.14.0
+    void attach(const void *data);
+    //! Returns `true` if all indices in the block are in range. @since 0.14.0
+    [[nodiscard]] bool valid() const;
+    [[nodiscard]] uint32_t step(uint32_t node, char32_t codepoint) const;
+    [[nodiscard]] uint32_t child(uint32_t node, char32_t codepoint) const;
+};
+} // namespace mastorss
+
+#endif // MASTORSS_WATCHWORD_MATCHER_HPP
@@ -0,0 +1,140 @@
+#include "circuit_breaker.hpp"
+#include "curl_wrapper.hpp"
+#include "exceptions.hpp"
+
+#include <boost/filesystem.hpp>
+#include <catch.hpp>
+
+#include <chrono>
+#include <fstream>
+
+namespace mastorss
+{
+
+namespace fs = boost::filesystem;
+using std::chrono::minutes;
+using std::chrono::system_clock;
+
+SCENARIO("Skipping failing hosts")
+{
+    const fs::path path{fs::temp_directory_path()
+                        / fs::unique_path("mastorss-test-%%%%-%%%%.json")};
+    CircuitBreaker breaker{path};
+
+    WHEN("A host fails once")
+    {
+        breaker.failed("example.com");
+
+        THEN("It is not skipped")
+        {
+            REQUIRE_FALSE(breaker.blocked("example.com").has_value());
+        }
+    }
+
+    WHEN("A host fails twice in a row")
+    {
+        const auto before{system_clock::now()};
+        breaker.failed("example.com");
+        breaker.failed("example.com");
+        const auto probe{breaker.blocked("example.com")};
+
+        THEN("It is skipped until the next probe")
+        AND_THEN("Other hosts are not skipped")
+        {
+            REQUIRE(probe.has_value());
+            REQUIRE(*probe >= before + minutes{14});
+            REQUIRE(*probe <= system_clock::now() + minutes{16});
+            REQUIRE_FALSE(breaker.blocked("example.org").has_value());
+        }
+
+        THEN("Other breakers with the same file skip it too")
+        {
+            REQUIRE(CircuitBreaker{path}.blocked("example.com").has_value());
+        }
+    }
+
+    WHEN("A failing host succeeds")
+    {
+        breaker.failed("example.com");
+        breaker.failed("example.com");
+        breaker.succeeded("example.com");
+        breaker.failed("example.com");
+
+        THEN("The earlier failures are forgotten")
+        {
+            REQUIRE_FALSE(breaker.blocked("example.com").has_value());
+        }
+    }
+
+    WHEN("The next probe is due")
+    {
+        std::ofstream{path.string(), std::ios::trunc}
+            << R"({"example.com": {"failures": 3, "next_probe": 0}})";
+
+        THEN("One request is allowed, then the host is skipped again")
+        {
+            REQUIRE_FALSE(breaker.blocked("example.com").has_value());
+            const auto probe{breaker.blocked("example.com")};
+            REQUIRE(probe.has_value());
+            REQUIRE(*probe >= system_clock::now() + minutes{29});
+        }
+    }
+
+    fs::remove(path);
+}
+
+SCENARIO("A CircuitBreaker without a state file")
+{
+    CircuitBreaker breaker;
+    breaker.failed("example.com");
+    breaker.failed("example.com");
+
+    THEN("Nothing is skipped")
+    {
+        REQUIRE_FALSE(breaker.blocked("example.com").has_value());
+    }
+}
+
+SCENARIO("Finding the host of a feed")
+{
+    THEN("The host and port are returned in lowercase")
+    {
+        REQUIRE(CircuitBreaker::host_of("https://Example.COM/feed.rss")
+                == "example.com");
+        REQUIRE(CircuitBreaker::host_of("http://example.com:8080?feed")
+                == "example.com:8080");
+        REQUIRE(CircuitBreaker::host_of("https://user:pw@example.com#x")
+                == "example.com");
+        REQUIRE(CircuitBreaker::host_of("example.com/feed") == "example.com");
+    }
+}
+
+SCENARIO("Deciding which errors concern the whole host")
+{
+    THEN("Server errors and 429 do, other HTTP errors don't")
+    {
+        REQUIRE(CircuitBreaker::host_failure(HTTPException{500}));
+        REQUIRE(CircuitBreaker::host_failure(HTTPException{503}));
+        REQUIRE(CircuitBreaker::host_failure(HTTPException{429}));
+        REQUIRE_FALSE(CircuitBreaker::host_failure(HTTPException{404}));
+        REQUIRE_FALSE(CircuitBreaker::host_failure(HTTPException{410}));
+    }
+
+    THEN("Connection errors and timeouts do, unless the deadline was reached")
+    {
+        using curl_wrapper::CURLException;
+        REQUIRE(CircuitBreaker::host_failure(
+            CURLException{CURLE_COULDNT_CONNECT}));
+        REQUIRE(CircuitBreaker::host_failure(
+            CURLException{CURLE_COULDNT_RESOLVE_HOST}));
+        REQUIRE(CircuitBreaker::host_failure(
+            CURLException{CURLE_OPERATION_TIMEDOUT}));
+        REQUIRE_FALSE(CircuitBreaker::host_failure(
+            CURLException{CURLE_OPERATION_TIMEDOUT, "Deadline reached.",
+                          true}));
+        REQUIRE_FALSE(CircuitBreaker::host_failure(
+            CURLException{CURLE_WRITE_ERROR}));
+    }
+}
+
+} // namespace mastorss
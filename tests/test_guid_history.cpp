@@ -0,0 +1,194 @@
+#include "exceptions.hpp"
+#include "guid_history.hpp"
+
+#include <boost/filesystem.hpp>
+#include <catch.hpp>
+
+#include <fstream>
+#include <string>
+
+namespace mastorss
+{
+
+namespace fs = boost::filesystem;
+using std::string;
+using std::to_string;
+
+SCENARIO("Remembering GUIDs")
+{
+    GUIDHistory history{3};
+
+    WHEN("GUIDs are added")
+    {
+        history.push("a");
+        history.push("b");
+        history.push("a");
+
+        THEN("They are found, others are not")
+        AND_THEN("Duplicates are not added")
+        {
+            REQUIRE(history.contains("a"));
+            REQUIRE(history.contains("b"));
+            REQUIRE_FALSE(history.contains("c"));
+            REQUIRE(history.size() == 2);
+        }
+    }
+
+    WHEN("More GUIDs are added than fit")
+    {
+        for (const char *guid : {"a", "b", "c", "d"})
+        {
+            history.push(guid);
+        }
+
+        THEN("The oldest is forgotten")
+        {
+            REQUIRE(history.size() == 3);
+            REQUIRE_FALSE(history.contains("a"));
+            REQUIRE(history.contains("b"));
+            REQUIRE(history.contains("d"));
+        }
+    }
+
+    WHEN("The history shrinks")
+    {
+        for (const char *guid : {"a", "b", "c"})
+        {
+            history.push(guid);
+        }
+        history.set_capacity(2);
+
+        THEN("The newest GUIDs are kept")
+        {
+            REQUIRE(history.capacity() == 2);
+            REQUIRE(history.size() == 2);
+            REQUIRE_FALSE(history.contains("a"));
+            REQUIRE(history.contains("b"));
+            REQUIRE(history.contains("c"));
+        }
+    }
+}
+
+SCENARIO("Remembering many GUIDs")
+{
+    GUIDHistory history{1000};
+    for (size_t i{0}; i < 5000; ++i)
+    {
+        history.push("https://example.com/item/" + to_string(i));
+    }
+
+    THEN("Exactly the last ones are found")
+    {
+        size_t found{0};
+        for (size_t i{0}; i < 5000; ++i)
+        {
+            if (history.contains("https://example.com/item/" + to_string(i)))
+            {
+                REQUIRE(i >= 4000);
+                ++found;
+            }
+        }
+        REQUIRE(found == 1000);
+        REQUIRE(history.size() == 1000);
+    }
+}
+
+SCENARIO("The capacity of a GUIDHistory is clamped")
+{
+    REQUIRE(GUIDHistory{0}.capacity() == 1);
+    REQUIRE(GUIDHistory{GUIDHistory::max_capacity + 1}.capacity()
+            == GUIDHistory::max_capacity);
+    REQUIRE(GUIDHistory{}.capacity() == GUIDHistory::default_capacity);
+    REQUIRE(GUIDHistory{}.empty());
+}
+
+SCENARIO("Keeping the GUID history in a file")
+{
+    const fs::path path{fs::temp_directory_path()
+                        / fs::unique_path("mastorss-test-%%%%-%%%%.guids")};
+
+    {
+        GUIDHistory history{3};
+        history.push("before open");
+        history.open(path);
+        history.push("after open");
+        history.flush();
+    }
+
+    WHEN("The file is opened again")
+    {
+        GUIDHistory history{3};
+        history.open(path);
+
+        THEN("The GUIDs are still there")
+        {
+            REQUIRE(history.size() == 2);
+            REQUIRE(history.contains("before open"));
+            REQUIRE(history.contains("after open"));
+        }
+    }
+
+    WHEN("The file is opened with a smaller capacity")
+    {
+        {
+            GUIDHistory history{3};
+            history.open(path);
+            history.push("newest");
+        }
+        GUIDHistory history{2};
+        history.open(path);
+
+        THEN("It is resized and the newest GUIDs are kept")
+        {
+            REQUIRE(history.capacity() == 2);
+            REQUIRE_FALSE(history.contains("before open"));
+            REQUIRE(history.contains("after open"));
+            REQUIRE(history.contains("newest"));
+        }
+    }
+
+    WHEN("The file is opened read-only")
+    {
+        {
+            GUIDHistory history{3};
+            history.open(path, true);
+            history.push("not saved");
+            history.flush();
+
+            REQUIRE(history.contains("not saved"));
+        }
+        GUIDHistory history{3};
+        history.open(path);
+
+        THEN("Changes are not written")
+        {
+            REQUIRE_FALSE(history.contains("not saved"));
+            REQUIRE(history.size() == 2);
+        }
+    }
+
+    WHEN("The file is not a GUID state file")
+    {
+        std::ofstream{path.string(), std::ios::trunc} << "not a state file";
+        bool exception = false;
+
+        try
+        {
+            GUIDHistory history;
+            history.open(path);
+        }
+        catch (const FileException &e)
+        {
+            exception = true;
+        }
+
+        THEN("FileException is thrown")
+        {
+            REQUIRE(exception);
+        }
+    }
+
+    fs::remove(path);
+}
+
+} // namespace mastorss
@@ -0,0 +1,49 @@
+#include "html_entities.hpp"
+
+#include <catch.hpp>
+
+namespace mastorss
+{
+
+SCENARIO("Looking up named HTML character references")
+{
+    THEN("Common entities are found")
+    {
+        REQUIRE(find_html_entity("amp") == "&");
+        REQUIRE(find_html_entity("lt") == "<");
+        REQUIRE(find_html_entity("gt") == ">");
+        REQUIRE(find_html_entity("quot") == "\"");
+        REQUIRE(find_html_entity("nbsp") == "\xC2\xA0");
+        REQUIRE(find_html_entity("hellip") == "\xE2\x80\xA6");
+    }
+
+    THEN("The first and the last entry of the table are found")
+    {
+        REQUIRE(find_html_entity("AElig") == "\xC3\x86");
+        REQUIRE(find_html_entity("zwnj") == "\xE2\x80\x8C");
+    }
+
+    THEN("Entities with two code points are found")
+    {
+        REQUIRE(find_html_entity("NotEqualTilde") == "\xE2\x89\x82\xCC\xB8");
+        REQUIRE(find_html_entity("fjlig") == "fj");
+    }
+
+    THEN("Names are case sensitive")
+    {
+        REQUIRE(find_html_entity("AMP") == "&");
+        REQUIRE_FALSE(find_html_entity("Amp").has_value());
+        REQUIRE(find_html_entity("Dagger") != find_html_entity("dagger"));
+    }
+
+    THEN("Unknown names are not found")
+    {
+        REQUIRE_FALSE(find_html_entity("").has_value());
+        REQUIRE_FALSE(find_html_entity("foo").has_value());
+        REQUIRE_FALSE(find_html_entity("amp;").has_value());
+        REQUIRE_FALSE(find_html_entity("&amp").has_value());
+        REQUIRE_FALSE(find_html_entity("zzzzz").has_value());
+    }
+}
+
+} // namespace mastorss
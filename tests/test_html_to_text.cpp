@@ -0,0 +1,78 @@
+#include "html_to_text.hpp"
+
+#include <boost/filesystem.hpp>
+#include <catch.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace mastorss
+{
+
+namespace fs = boost::filesystem;
+using std::string;
+
+namespace
+{
+string read_file(const fs::path &path)
+{
+    std::ifstream file{path.string(), std::ios::binary};
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+} // namespace
+
+// The *.txt files were generated with the regular expressions that were used
+// before html_to_text() was written.
+SCENARIO("Converting the HTML corpus to text")
+{
+    const fs::path corpus{fs::path{TESTS_DATA_DIR} / "html_to_text"};
+    size_t checked{0};
+
+    for (const auto &entry : fs::directory_iterator{corpus})
+    {
+        const fs::path &path{entry.path()};
+        if (path.extension() != ".html")
+        {
+            continue;
+        }
+
+        const string expected{
+            read_file(fs::path{path}.replace_extension(".txt"))};
+        INFO(path.filename().string());
+        REQUIRE(html_to_text(read_file(path)) == expected);
+        ++checked;
+    }
+
+    REQUIRE(checked > 0);
+}
+
+SCENARIO("Converting HTML to text")
+{
+    THEN("Paragraphs and line breaks are collapsed into spaces")
+    {
+        REQUIRE(html_to_text("<p>a</p><p>b</p>") == "a b");
+        REQUIRE(html_to_text("a<br>b\n") == "a b\n");
+    }
+
+    THEN("Numeric references are decoded, invalid ones are kept")
+    {
+        REQUIRE(html_to_text("&#65;&#x42;&#X43;") == "ABC");
+        REQUIRE(html_to_text("&#0;&#xD800;&#x110000;")
+                == "&#0;&#xD800;&#x110000;");
+    }
+
+    THEN("Decoded markup is removed like real markup")
+    {
+        REQUIRE(html_to_text("x&lt;b&gt;y") == "xy");
+    }
+
+    THEN("An empty document stays empty")
+    {
+        REQUIRE(html_to_text("").empty());
+    }
+}
+
+} // namespace mastorss
@@ -0,0 +1,199 @@
+#include "config.hpp"
+#include "curl_wrapper.hpp"
+#include "poll_schedule.hpp"
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+namespace mastorss
+{
+
+using std::int64_t;
+using std::chrono::hours;
+using std::chrono::minutes;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+SCENARIO("Parsing Retry-After")
+{
+    THEN("Seconds and HTTP dates are understood")
+    {
+        REQUIRE(parse_retry_after("120") == seconds{120});
+        REQUIRE(parse_retry_after("Wed, 21 Oct 2015 07:28:00 GMT")
+                == seconds{0});
+        const auto delay{parse_retry_after("Fri, 31 Dec 2100 23:59:59 GMT")};
+        REQUIRE(delay.has_value());
+        REQUIRE(*delay > hours{24 * 365 * 50});
+    }
+
+    THEN("Empty and invalid values are ignored")
+    {
+        REQUIRE_FALSE(parse_retry_after("").has_value());
+        REQUIRE_FALSE(parse_retry_after("soon").has_value());
+    }
+}
+
+SCENARIO("Hints of the server")
+{
+    curl_wrapper::answer answer;
+
+    WHEN("Cache-Control has max-age")
+    {
+        answer.headers = "HTTP/1.1 200 OK\r\n"
+                         "Cache-Control: public, Max-Age=300\r\n"
+                         "Expires: Fri, 31 Dec 2100 23:59:59 GMT\r\n";
+
+        THEN("It is used instead of Expires")
+        {
+            REQUIRE(http_poll_hint(answer) == seconds{300});
+        }
+    }
+
+    WHEN("Retry-After is longer")
+    {
+        answer.headers = "HTTP/1.1 503 Service Unavailable\r\n"
+                         "Cache-Control: max-age=300\r\n"
+                         "Retry-After: 600\r\n";
+
+        THEN("Retry-After is used")
+        {
+            REQUIRE(http_poll_hint(answer) == seconds{600});
+        }
+    }
+
+    WHEN("There are no hints")
+    {
+        answer.headers = "HTTP/1.1 200 OK\r\n"
+                         "Expires: Wed, 21 Oct 2015 07:28:00 GMT\r\n";
+
+        THEN("The hint is 0")
+        {
+            REQUIRE(http_poll_hint(answer) == seconds{0});
+        }
+    }
+}
+
+SCENARIO("Hints of the feed")
+{
+    THEN("ttl is in minutes")
+    {
+        REQUIRE(feed_poll_hint("60", "", "") == minutes{60});
+        REQUIRE(feed_poll_hint(" 30 ", "", "") == minutes{30});
+    }
+
+    THEN("The period is divided by the frequency")
+    {
+        REQUIRE(feed_poll_hint("", "hourly", "2") == minutes{30});
+        REQUIRE(feed_poll_hint("", "weekly", "7") == hours{24});
+        REQUIRE(feed_poll_hint("", "", "4") == hours{6});
+        REQUIRE(feed_poll_hint("", "daily", "0") == hours{24});
+    }
+
+    THEN("The longest hint is used")
+    {
+        REQUIRE(feed_poll_hint("120", "hourly", "1") == hours{2});
+        REQUIRE(feed_poll_hint("10", "hourly", "1") == hours{1});
+    }
+
+    THEN("Without hints the hint is 0")
+    {
+        REQUIRE(feed_poll_hint("", "", "") == seconds{0});
+        REQUIRE(feed_poll_hint("often", "", "") == seconds{0});
+    }
+}
+
+SCENARIO("Checking if a feed is due")
+{
+    const auto now{system_clock::from_time_t(1000000000)};
+    ProfileData data;
+
+    THEN("Feeds are due if the check is at most a minute early")
+    {
+        data.next_check = 1000000000 + 60;
+        REQUIRE_FALSE(not_due(data, now).has_value());
+        data.next_check = 0;
+        REQUIRE_FALSE(not_due(data, now).has_value());
+    }
+
+    THEN("Otherwise the remaining time is returned")
+    {
+        data.next_check = 1000000000 + 3600;
+        REQUIRE(not_due(data, now) == seconds{3600});
+    }
+}
+
+SCENARIO("Planning the next check")
+{
+    const int64_t start{1000000000};
+    ProfileData data;
+
+    WHEN("The feed is checked for the first time")
+    {
+        plan_next_check(data, false, seconds{600},
+                        system_clock::from_time_t(start));
+
+        THEN("The check counts as an arrival and the hint is used")
+        {
+            REQUIRE(data.arrivals.size() == 1);
+            REQUIRE(data.next_check == start + 600);
+        }
+    }
+
+    WHEN("Items arrive every hour")
+    {
+        for (int64_t i{0}; i < 5; ++i)
+        {
+            data.arrivals.push_back(start + i * 3600);
+        }
+        const int64_t last{data.arrivals.back()};
+
+        THEN("The feed is checked every half hour")
+        {
+            plan_next_check(data, true, seconds{0},
+                            system_clock::from_time_t(last + 3600));
+            REQUIRE(data.next_check == last + 3600 + 1800);
+        }
+
+        THEN("Quiet feeds are checked less often")
+        {
+            plan_next_check(data, false, seconds{0},
+                            system_clock::from_time_t(last + 20000));
+            REQUIRE(data.next_check == last + 20000 + 5000);
+            REQUIRE(data.arrivals.size() == 5);
+        }
+
+        THEN("A longer hint wins")
+        {
+            plan_next_check(data, true, hours{2},
+                            system_clock::from_time_t(last + 3600));
+            REQUIRE(data.next_check == last + 3600 + 7200);
+        }
+
+        THEN("The interval is limited by max_check_interval")
+        {
+            data.max_check_interval = 1000;
+            plan_next_check(data, false, hours{2},
+                            system_clock::from_time_t(last + 3600));
+            REQUIRE(data.next_check == last + 3600 + 1000);
+        }
+    }
+
+    WHEN("Many items arrive")
+    {
+        for (int64_t i{0}; i < 20; ++i)
+        {
+            plan_next_check(data, true, seconds{0},
+                            system_clock::from_time_t(start + i * 60));
+        }
+
+        THEN("Only the last arrivals are remembered")
+        {
+            REQUIRE(data.arrivals.size() == max_arrivals);
+            REQUIRE(data.arrivals.back() == start + 19 * 60);
+        }
+    }
+}
+
+} // namespace mastorss
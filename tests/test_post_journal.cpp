@@ -0,0 +1,141 @@
+#include "guid_history.hpp"
+#include "item.hpp"
+#include "post_journal.hpp"
+
+#include <boost/filesystem.hpp>
+#include <catch.hpp>
+
+#include <fstream>
+#include <list>
+#include <string>
+
+namespace mastorss
+{
+
+namespace fs = boost::filesystem;
+using std::list;
+using std::string;
+
+SCENARIO("Journaling items")
+{
+    const fs::path path{fs::temp_directory_path()
+                        / fs::unique_path("mastorss-test-%%%%-%%%%.journal")};
+    const list<Item> items{{"Description 1", "g1", "https://example.com/1",
+                            "Title 1"},
+                           {"Description 2", "g2", "https://example.com/2",
+                            "Title 2"}};
+
+    {
+        PostJournal journal;
+        journal.open(path);
+        journal.append(items);
+        journal.append({items.front()});
+    }
+
+    WHEN("The journal is opened again")
+    {
+        PostJournal journal;
+        journal.open(path);
+
+        THEN("The items are pending, without duplicates")
+        {
+            REQUIRE(journal.pending().size() == 2);
+            REQUIRE(journal.pending().front().guid == "g1");
+            REQUIRE(journal.pending().front().title == "Title 1");
+            REQUIRE(journal.pending().back().description == "Description 2");
+            REQUIRE(journal.pending().back().link == "https://example.com/2");
+        }
+    }
+
+    WHEN("An item is committed")
+    {
+        {
+            PostJournal journal;
+            journal.open(path);
+            journal.commit("g1");
+            journal.sync();
+        }
+        PostJournal journal;
+        journal.open(path);
+        GUIDHistory guids;
+        journal.restore(guids);
+
+        THEN("It is not pending anymore")
+        AND_THEN("Its GUID is restored")
+        {
+            REQUIRE(journal.pending().size() == 1);
+            REQUIRE(journal.pending().front().guid == "g2");
+            REQUIRE(guids.contains("g1"));
+            REQUIRE_FALSE(guids.contains("g2"));
+        }
+    }
+
+    WHEN("An item was posted but not committed")
+    {
+        GUIDHistory guids;
+        guids.push("g2");
+        PostJournal journal;
+        journal.open(path);
+        journal.restore(guids);
+
+        THEN("It is committed while restoring")
+        {
+            REQUIRE(journal.pending().size() == 1);
+            REQUIRE(journal.pending().front().guid == "g1");
+        }
+    }
+
+    WHEN("The last record was only partially written")
+    {
+        std::ofstream{path.string(), std::ios::app | std::ios::binary}
+            << "\x02partial";
+        {
+            PostJournal journal;
+            journal.open(path);
+            journal.append({{"", "g3", "", ""}});
+        }
+        PostJournal journal;
+        journal.open(path);
+
+        THEN("It is discarded and new records are read")
+        {
+            REQUIRE(journal.pending().size() == 3);
+            REQUIRE(journal.pending().back().guid == "g3");
+        }
+    }
+
+    WHEN("The journal is cleared")
+    {
+        {
+            PostJournal journal;
+            journal.open(path);
+            journal.clear();
+        }
+        PostJournal journal;
+        journal.open(path);
+
+        THEN("Nothing is pending")
+        {
+            REQUIRE(journal.pending().empty());
+        }
+    }
+
+    fs::remove(path);
+}
+
+SCENARIO("Read-only journals")
+{
+    const fs::path path{fs::temp_directory_path()
+                        / fs::unique_path("mastorss-test-%%%%-%%%%.journal")};
+    PostJournal journal;
+    journal.open(path, true);
+    journal.append({{"", "g1", "", ""}});
+
+    THEN("Items are kept in memory only")
+    {
+        REQUIRE(journal.pending().size() == 1);
+        REQUIRE_FALSE(fs::exists(path));
+    }
+}
+
+} // namespace mastorss
@@ -0,0 +1,112 @@
+#include "exceptions.hpp"
+#include "post_template.hpp"
+#include "text_length.hpp"
+
+#include <catch.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace mastorss
+{
+
+using std::string;
+using std::string_view;
+
+SCENARIO("Rendering a post template")
+{
+    const PostTemplate post{"{title}\n\n{description}\n\n{link}{append}"};
+    const PostTemplate::fields values{"Title", "one two three four five",
+                                      "https://example.com/a/very/long/path",
+                                      "\n#tag"};
+    string out;
+
+    WHEN("The post is short enough")
+    {
+        post.render(values, 500, out);
+
+        THEN("All fields are filled in")
+        {
+            REQUIRE(out
+                    == "Title\n\none two three four five\n\n"
+                       "https://example.com/a/very/long/path\n#tag");
+        }
+    }
+
+    WHEN("The post is too long")
+    {
+        post.render(values, 50, out);
+
+        THEN("The text is shortened at a word boundary")
+        AND_THEN("The link and the appendix are kept")
+        {
+            REQUIRE(out
+                    == "Title\n\none two […]\n\n"
+                       "https://example.com/a/very/long/path\n#tag");
+            REQUIRE(status_length(out) <= 50);
+        }
+    }
+
+    WHEN("The output string is reused")
+    {
+        out = "old content";
+        post.render(values, 500, out);
+
+        THEN("The old content is replaced")
+        {
+            REQUIRE(out.substr(0, 5) == "Title");
+        }
+    }
+}
+
+SCENARIO("Literal text in post templates")
+{
+    const PostTemplate post{"{{{title}}} {{link}}"};
+    string out;
+    post.render({"T", "", "L", ""}, 500, out);
+
+    THEN("Double braces are literal braces")
+    {
+        REQUIRE(out == "{T} {link}");
+    }
+}
+
+SCENARIO("Templates without title and description are not shortened")
+{
+    const PostTemplate post{"{link}{append}"};
+    string out;
+    post.render({"", "", "https://example.com/", " and more text"}, 5, out);
+
+    THEN("The output is complete")
+    {
+        REQUIRE(out == "https://example.com/ and more text");
+    }
+}
+
+SCENARIO("Invalid post templates")
+{
+    const auto throws_config_exception{[](const string_view text)
+    {
+        try
+        {
+            const PostTemplate post{text};
+        }
+        catch (const ConfigException &)
+        {
+            return true;
+        }
+        return false;
+    }};
+
+    THEN("ConfigException is thrown")
+    {
+        REQUIRE(throws_config_exception("{title"));
+        REQUIRE(throws_config_exception("title}"));
+        REQUIRE(throws_config_exception("{unknown}"));
+        REQUIRE(throws_config_exception("{}"));
+        REQUIRE_FALSE(throws_config_exception(""));
+        REQUIRE_FALSE(throws_config_exception("{{}}"));
+    }
+}
+
+} // namespace mastorss
@@ -0,0 +1,70 @@
+#include "prefix_trie.hpp"
+
+#include <catch.hpp>
+
+#include <string_view>
+#include <vector>
+
+namespace mastorss
+{
+
+using std::string_view;
+using std::vector;
+
+SCENARIO("Finding keys at the start of a text")
+{
+    const vector<string_view> keys{"foo", "bar", "baz", "x", "xyz", "foo"};
+    const PrefixTrie trie{keys};
+
+    THEN("The key the text starts with is found")
+    {
+        REQUIRE(trie.match("foobar") == 0);
+        REQUIRE(trie.match("bar") == 1);
+        REQUIRE(trie.match("baz") == 2);
+        REQUIRE(trie.match("a bar") == std::nullopt);
+    }
+
+    THEN("Keys that start with another key are never found")
+    {
+        REQUIRE(trie.match("xyz") == 3);
+        REQUIRE(trie.match("x") == 3);
+    }
+
+    THEN("Texts that are shorter than the key don't match")
+    {
+        REQUIRE(trie.match("fo") == std::nullopt);
+        REQUIRE(trie.match("") == std::nullopt);
+    }
+
+    THEN("The first index of duplicate keys is returned")
+    {
+        REQUIRE(trie.match("foo") == 0);
+    }
+}
+
+SCENARIO("Keys with bytes outside of ASCII")
+{
+    const vector<string_view> keys{"\xC3\xA4", "\xC3\xB6", "\xFF"};
+    const PrefixTrie trie{keys};
+
+    THEN("They are found")
+    {
+        REQUIRE(trie.match("\xC3\xB6l") == 1);
+        REQUIRE(trie.match("\xFF") == 2);
+        REQUIRE(trie.match("\xC3") == std::nullopt);
+    }
+}
+
+SCENARIO("A PrefixTrie without keys")
+{
+    const PrefixTrie trie;
+
+    THEN("It is empty and never matches")
+    {
+        REQUIRE(trie.empty());
+        REQUIRE(trie.match("foo") == std::nullopt);
+        REQUIRE(PrefixTrie{vector<string_view>{}}.match("") == std::nullopt);
+    }
+}
+
+} // namespace mastorss
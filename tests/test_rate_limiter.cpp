@@ -0,0 +1,125 @@
+#include "rate_limiter.hpp"
+
+#include <boost/filesystem.hpp>
+#include <catch.hpp>
+
+#include <chrono>
+#include <string>
+
+namespace mastorss
+{
+
+namespace fs = boost::filesystem;
+using std::string;
+using std::to_string;
+using std::chrono::hours;
+using std::chrono::system_clock;
+
+SCENARIO("Pacing posts with a RateLimiter")
+{
+    const fs::path path{fs::temp_directory_path()
+                        / fs::unique_path("mastorss-test-%%%%-%%%%.json")};
+    const auto in_an_hour{system_clock::now() + hours{1}};
+    const string reset{to_string(system_clock::to_time_t(in_an_hour))};
+
+    WHEN("Nothing is known about the allowance")
+    {
+        RateLimiter limiter{path};
+
+        THEN("Posts are allowed")
+        {
+            REQUIRE_FALSE(limiter.reserve().has_value());
+            REQUIRE_FALSE(limiter.reserve().has_value());
+        }
+    }
+
+    WHEN("The allowance is used up")
+    {
+        RateLimiter limiter{path};
+        limiter.update("300", "2", reset);
+
+        THEN("It is counted down and the renewal is returned")
+        {
+            REQUIRE_FALSE(limiter.reserve().has_value());
+            REQUIRE_FALSE(limiter.reserve().has_value());
+            const auto renewal{limiter.reserve()};
+            REQUIRE(renewal.has_value());
+            REQUIRE(system_clock::to_time_t(*renewal)
+                    == system_clock::to_time_t(in_an_hour));
+        }
+    }
+
+    WHEN("Another limiter uses the same file")
+    {
+        RateLimiter{path}.update("300", "1", reset);
+        REQUIRE_FALSE(RateLimiter{path}.reserve().has_value());
+
+        THEN("The allowance is shared")
+        {
+            REQUIRE(RateLimiter{path}.reserve().has_value());
+        }
+    }
+
+    WHEN("The allowance was renewed")
+    {
+        RateLimiter limiter{path};
+        limiter.update("1", "0", "2000-01-01T00:00:00.000Z");
+        const auto before{system_clock::now()};
+
+        THEN("A new window with the limit is opened")
+        {
+            REQUIRE_FALSE(limiter.reserve().has_value());
+            const auto renewal{RateLimiter{path}.reserve()};
+            REQUIRE(renewal.has_value());
+            REQUIRE(*renewal >= before + RateLimiter::assumed_window
+                                    - std::chrono::seconds{1});
+        }
+
+        THEN("A response replaces the assumed reset")
+        {
+            REQUIRE_FALSE(limiter.reserve().has_value());
+            limiter.update("1", "1", reset);
+            REQUIRE_FALSE(limiter.reserve().has_value());
+            REQUIRE(limiter.reserve().has_value());
+        }
+    }
+
+    WHEN("The allowance is exhausted")
+    {
+        RateLimiter limiter{path};
+        limiter.exhaust(in_an_hour);
+
+        THEN("Posts have to wait")
+        {
+            REQUIRE(limiter.reserve().has_value());
+        }
+    }
+
+    WHEN("The headers are empty or invalid")
+    {
+        RateLimiter limiter{path};
+        limiter.update("300", "0", reset);
+        limiter.update("", "", "");
+        limiter.update("many", "some", "soon");
+
+        THEN("They are ignored")
+        {
+            REQUIRE(limiter.reserve().has_value());
+        }
+    }
+
+    fs::remove(path);
+}
+
+SCENARIO("A RateLimiter without a state file")
+{
+    RateLimiter limiter;
+    limiter.exhaust(system_clock::now() + hours{1});
+
+    THEN("Everything is allowed")
+    {
+        REQUIRE_FALSE(limiter.reserve().has_value());
+    }
+}
+
+} // namespace mastorss
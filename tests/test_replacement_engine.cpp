@@ -0,0 +1,123 @@
+#include "exceptions.hpp"
+#include "replacement_engine.hpp"
+
+#include <boost/regex.hpp>
+#include <catch.hpp>
+
+#include <list>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mastorss
+{
+
+using std::list;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace
+{
+// What ReplacementEngine replaces.
+string apply_sequentially(const list<pair<string, string>> &replacements,
+                          string text)
+{
+    for (const auto &replacement : replacements)
+    {
+        text = boost::regex_replace(text, boost::regex{replacement.first},
+                                    replacement.second);
+    }
+    return text;
+}
+} // namespace
+
+SCENARIO("Applying replacements")
+{
+    THEN("Literal replacements are applied in order")
+    {
+        const ReplacementEngine engine{{{"a", "b"}, {"b", "c"}, {"xy", ""}},
+                                       "replacements"};
+        REQUIRE(engine.apply("a b xyz") == "c c z");
+    }
+
+    THEN("Regular expressions and literals can be mixed")
+    {
+        const ReplacementEngine engine{
+            {{"Read more", ""}, {"\\s+$", ""}, {"[0-9]+", "#"}, {"#", "n"}},
+            "replacements"};
+        REQUIRE(engine.apply("1 or 22. Read more  ") == "n or n.");
+    }
+
+    THEN("Back references work in regular expressions")
+    {
+        const ReplacementEngine engine{{{"(\\w+)@(\\w+)", "$2 at $1"}},
+                                       "replacements"};
+        REQUIRE(engine.apply("me@home") == "home at me");
+    }
+
+    THEN("Without replacements the text doesn't change")
+    {
+        REQUIRE(ReplacementEngine{}.apply("text") == "text");
+    }
+}
+
+SCENARIO("Invalid replacements")
+{
+    bool exception = false;
+
+    try
+    {
+        const ReplacementEngine engine{{{"(", ""}}, "replacements"};
+    }
+    catch (const ConfigException &e)
+    {
+        exception = true;
+    }
+
+    THEN("ConfigException is thrown")
+    {
+        REQUIRE(exception);
+    }
+}
+
+SCENARIO("ReplacementEngine gives the same result as boost::regex_replace")
+{
+    const vector<string> patterns{"a",  "b",   "ab", "ba",  "aa", "c",
+                                  "a+", "b|c", "",   "\\.", "."};
+    const vector<string> formats{"", "a", "b", "ab", "c", "$0$0", "x"};
+    const vector<string> words{"a", "b", "c", "ab", " ", "."};
+    std::mt19937 rng{42};
+    size_t different{0};
+
+    for (size_t n{0}; n < 2000; ++n)
+    {
+        list<pair<string, string>> replacements;
+        for (size_t i{rng() % 5 + 1}; i > 0; --i)
+        {
+            const string &pattern{patterns[rng() % patterns.size()]};
+            if (pattern.empty())
+            {
+                continue;
+            }
+            replacements.emplace_back(pattern, formats[rng() % formats.size()]);
+        }
+        string text;
+        for (size_t i{rng() % 10}; i > 0; --i)
+        {
+            text += words[rng() % words.size()];
+        }
+
+        const ReplacementEngine engine{replacements, "replacements"};
+        if (engine.apply(text) != apply_sequentially(replacements, text))
+        {
+            INFO(text);
+            ++different;
+        }
+    }
+
+    REQUIRE(different == 0);
+}
+
+} // namespace mastorss
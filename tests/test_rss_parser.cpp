@@ -0,0 +1,273 @@
+#include "exceptions.hpp"
+#include "rss_parser.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <catch.hpp>
+
+#include <exception>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mastorss
+{
+
+using std::string;
+using std::vector;
+
+namespace
+{
+const string feed{R"(<?xml version="1.0" encoding="UTF-8"?>
+<!DOCTYPE rss [ <!ENTITY unused "x"> ]>
+<rss version="2.0" xmlns:sy="http://purl.org/rss/1.0/modules/syndication/">
+  <channel>
+    <title>Example</title>
+    <ttl>60</ttl>
+    <sy:updatePeriod>hourly</sy:updatePeriod>
+    <sy:updateFrequency>2</sy:updateFrequency>
+    <!-- <item><guid>commented out</guid></item> -->
+    <item>
+      <title>First &amp; &lt;best&gt; &#x41;&#66;</title>
+      <link>https://example.com/1</link>
+      <guid isPermaLink="false">g1</guid>
+      <description><![CDATA[<p>Some <b>HTML</b> &amp; more</p>]]></description>
+    </item>
+    <item>
+      <title>Second</title>
+      <title>Ignored</title>
+      <link>https://example.com/2</link>
+      <description>before<em>child</em>after</description>
+    </item>
+    <item>
+      <title/>
+      <guid>g3</guid>
+    </item>
+  </channel>
+</rss>
+)"};
+
+//! Parse `document` in chunks of `chunk_size` bytes.
+vector<RSSParser::item> parse(const string &document, const size_t chunk_size)
+{
+    vector<RSSParser::item> items;
+    RSSParser parser{[&items](RSSParser::item &rssitem)
+                     {
+                         items.push_back(rssitem);
+                         return true;
+                     }};
+    for (size_t pos{0}; pos < document.size(); pos += chunk_size)
+    {
+        parser.feed(string_view(document).substr(pos, chunk_size));
+    }
+    parser.finish();
+
+    return items;
+}
+
+bool equal(const vector<RSSParser::item> &a, const vector<RSSParser::item> &b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i{0}; i < a.size(); ++i)
+    {
+        if (a[i].description != b[i].description || a[i].guid != b[i].guid
+            || a[i].link != b[i].link || a[i].title != b[i].title)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+SCENARIO("Parsing an RSS feed")
+{
+    bool exception = false;
+    vector<RSSParser::item> items;
+
+    WHEN("Parsing the whole feed at once")
+    {
+        try
+        {
+            items = parse(feed, feed.size());
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        AND_THEN("All items are found")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(items.size() == 3);
+        }
+
+        THEN("Entities are decoded and CDATA is kept as it is")
+        {
+            REQUIRE(items[0].title == "First & <best> AB");
+            REQUIRE(items[0].guid == "g1");
+            REQUIRE(items[0].description
+                    == "<p>Some <b>HTML</b> &amp; more</p>");
+        }
+
+        THEN("The first element counts and child elements are left out")
+        {
+            REQUIRE(items[1].title == "Second");
+            REQUIRE(items[1].description == "beforeafter");
+        }
+
+        THEN("Missing elements are empty, empty elements are not")
+        {
+            REQUIRE_FALSE(items[1].guid.has_value());
+            REQUIRE(items[2].title == "");
+            REQUIRE_FALSE(items[2].link.has_value());
+        }
+    }
+
+    WHEN("Parsing the feed in chunks of every size")
+    {
+        bool all_equal{true};
+        try
+        {
+            const auto whole{parse(feed, feed.size())};
+            for (size_t size{1}; size < feed.size(); ++size)
+            {
+                all_equal = all_equal && equal(parse(feed, size), whole);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("The result is always the same")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(all_equal);
+        }
+    }
+}
+
+SCENARIO("Parsing the channel of an RSS feed")
+{
+    RSSParser parser{[](RSSParser::item &) { return true; }};
+    parser.feed(feed);
+    parser.finish();
+    const auto &channel{parser.get_channel()};
+
+    THEN("The update elements are found with any namespace prefix")
+    {
+        REQUIRE(channel.ttl == "60");
+        REQUIRE(channel.update_period == "hourly");
+        REQUIRE(channel.update_frequency == "2");
+    }
+}
+
+SCENARIO("Stopping the RSS parser")
+{
+    size_t calls{0};
+    RSSParser parser{[&calls](RSSParser::item &)
+                     {
+                         ++calls;
+                         return false;
+                     }};
+    bool result{true};
+    bool exception = false;
+
+    WHEN("The handler returns false after the first item")
+    {
+        try
+        {
+            result = parser.feed(feed.substr(0, feed.find("</item>") + 7));
+            result = parser.feed(feed.substr(feed.find("</item>") + 7)
+                                 + "<<<garbage");
+            parser.finish();
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("The rest of the document is ignored")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE_FALSE(result);
+            REQUIRE(parser.stopped());
+            REQUIRE(calls == 1);
+        }
+    }
+}
+
+SCENARIO("Invalid feeds")
+{
+    const auto throws_parse_exception{[](const string &document)
+    {
+        try
+        {
+            parse(document, document.size());
+        }
+        catch (const ParseException &)
+        {
+            return true;
+        }
+        return false;
+    }};
+
+    THEN("Other feed types are rejected")
+    {
+        REQUIRE(throws_parse_exception(
+            R"(<feed xmlns="http://www.w3.org/2005/Atom"></feed>)"));
+        REQUIRE(throws_parse_exception("not XML at all"));
+    }
+
+    THEN("Incomplete and malformed feeds are rejected")
+    {
+        REQUIRE(throws_parse_exception(feed.substr(0, feed.size() / 2)));
+        REQUIRE(throws_parse_exception(
+            "<rss><channel><item></channel></item></rss>"));
+    }
+}
+
+SCENARIO("The RSS parser gives the same items as boost::property_tree")
+{
+    namespace pt = boost::property_tree;
+
+    // Without the comment and the DOCTYPE, property_tree can't read those.
+    const size_t rss{feed.find("<rss ")};
+    const string document{feed.substr(0, feed.find("<!DOCTYPE"))
+                          + feed.substr(rss, feed.find("<!--") - rss)
+                          + feed.substr(feed.find("-->") + 3)};
+
+    pt::ptree tree;
+    std::istringstream stream{document};
+    pt::read_xml(stream, tree);
+    vector<RSSParser::item> expected;
+    for (const auto &child : tree.get_child("rss.channel"))
+    {
+        if (child.first == "item")
+        {
+            const auto get{[&child](const string &name) -> optional<string>
+            {
+                if (const auto value{child.second.get_optional<string>(name)})
+                {
+                    return *value;
+                }
+                return {};
+            }};
+            expected.push_back({get("description"), get("guid"), get("link"),
+                                get("title")});
+        }
+    }
+
+    THEN("The items are equal")
+    {
+        REQUIRE(expected.size() == 3);
+        REQUIRE(equal(parse(document, 7), expected));
+    }
+}
+
+} // namespace mastorss
@@ -0,0 +1,55 @@
+#include "state_file.hpp"
+
+#include <boost/filesystem.hpp>
+#include <catch.hpp>
+#include <json/json.h>
+
+namespace mastorss
+{
+
+namespace fs = boost::filesystem;
+
+SCENARIO("Changing a state file")
+{
+    const fs::path dir{fs::temp_directory_path()
+                       / fs::unique_path("mastorss-test-%%%%-%%%%")};
+    fs::create_directory(dir);
+    const fs::path path{dir / "state.json"};
+
+    WHEN("A value is set")
+    {
+        modify_state_file(path, [](Json::Value &json) { json["a"] = 1; });
+
+        THEN("It is read back")
+        {
+            REQUIRE(read_state_file(path)["a"].asInt() == 1);
+        }
+    }
+
+    WHEN("Nothing is changed")
+    {
+        modify_state_file(path, [](Json::Value &) {});
+
+        THEN("The file is not created")
+        {
+            REQUIRE_FALSE(fs::exists(path));
+            REQUIRE(read_state_file(path) == Json::Value{Json::objectValue});
+        }
+    }
+
+    WHEN("Writing the new file fails")
+    {
+        modify_state_file(path, [](Json::Value &json) { json["a"] = 1; });
+        fs::create_directory(path.string() + ".new");
+        modify_state_file(path, [](Json::Value &json) { json["a"] = 2; });
+
+        THEN("The old file is intact")
+        {
+            REQUIRE(read_state_file(path)["a"].asInt() == 1);
+        }
+    }
+
+    fs::remove_all(dir);
+}
+
+} // namespace mastorss
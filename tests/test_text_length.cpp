@@ -0,0 +1,94 @@
+#include "text_length.hpp"
+
+#include <catch.hpp>
+
+#include <array>
+#include <random>
+#include <string>
+
+namespace mastorss
+{
+
+using std::string;
+
+SCENARIO("Counting code points")
+{
+    THEN("Every code point counts once")
+    {
+        REQUIRE(count_code_points("") == 0);
+        REQUIRE(count_code_points("abc") == 3);
+        REQUIRE(count_code_points("äöü") == 3);
+        REQUIRE(count_code_points("€ 🐘") == 3);
+    }
+
+    THEN("Long texts are counted correctly")
+    {
+        // Longer than one SSE2 block, with code points across the borders.
+        string text;
+        size_t expected{0};
+        std::mt19937 rng{42};
+        constexpr std::array<const char *, 4> chars{"a", "ß", "€", "🐘"};
+        for (size_t i{0}; i < 1000; ++i)
+        {
+            text += chars.at(rng() % chars.size());
+            ++expected;
+            REQUIRE(count_code_points(text) == expected);
+        }
+    }
+}
+
+SCENARIO("Counting the length of a status")
+{
+    THEN("URLs count as 23 characters")
+    {
+        REQUIRE(status_length("https://example.com/a/long/path/to/a/page")
+                == url_length);
+        REQUIRE(status_length("see http://example.com.") == 4 + url_length + 1);
+        REQUIRE(status_length("(https://example.com/x) and https://ex.am.ple")
+                == 1 + url_length + 6 + url_length);
+    }
+
+    THEN("Things that look like URLs but aren't count normally")
+    {
+        REQUIRE(status_length("https://localhost/") == 18);
+        REQUIRE(status_length("xhttps://example.com") == 20);
+        REQUIRE(status_length("https://example.c0m") == 19);
+        REQUIRE(status_length("ftp://example.com") == 17);
+    }
+
+    THEN("Internationalized top level domains are URLs")
+    {
+        REQUIRE(status_length("https://example.xn--p1ai") == url_length);
+    }
+}
+
+SCENARIO("Fitting a status into a length")
+{
+    THEN("Code points are not cut")
+    {
+        REQUIRE(fit_status("äöü", 2) == 4);
+        REQUIRE(fit_status("äöü", 3) == 6);
+        REQUIRE(fit_status("äöü", 10) == 6);
+        REQUIRE(fit_status("abc", 0) == 0);
+    }
+
+    THEN("URLs are not cut")
+    {
+        const string text{"ab https://example.com/a/long/path cd"};
+        REQUIRE(fit_status(text, 3 + url_length - 1) == 3);
+        REQUIRE(fit_status(text, 3 + url_length) == 34);
+        REQUIRE(fit_status(text, 3 + url_length + 2) == 36);
+    }
+
+    THEN("The result is never longer than the maximum")
+    {
+        const string text{"Ä https://example.com/ 🐘 http://b.de, x"};
+        for (size_t max{0}; max < 60; ++max)
+        {
+            const size_t size{fit_status(text, max)};
+            REQUIRE(status_length(text.substr(0, size)) <= max);
+        }
+    }
+}
+
+} // namespace mastorss
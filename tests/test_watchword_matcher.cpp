@@ -0,0 +1,168 @@
+#include "watchword_matcher.hpp"
+
+#include <boost/filesystem.hpp>
+#include <catch.hpp>
+
+#include <list>
+#include <string>
+
+namespace mastorss
+{
+
+namespace fs = boost::filesystem;
+using std::list;
+using std::string;
+
+SCENARIO("Watchwords need a word boundary")
+{
+    const WatchwordMatcher matcher{list<string>{"linux", "c++"}};
+
+    THEN("Whitespace, U+200B and the ends of the text are boundaries")
+    {
+        REQUIRE(matcher.add_hashtags("linux") == "#linux");
+        REQUIRE(matcher.add_hashtags("I use linux.") == "I use #linux.");
+        REQUIRE(matcher.add_hashtags("a\tlinux\nb") == "a\t#linux\nb");
+        REQUIRE(matcher.add_hashtags("\xE2\x80\x8Blinux\xE2\x80\x8B")
+                == "\xE2\x80\x8B#linux\xE2\x80\x8B");
+    }
+
+    THEN("Punctuation is a boundary after the watchword, not before")
+    {
+        REQUIRE(matcher.add_hashtags("linux, linux!") == "#linux, linux!");
+        REQUIRE(matcher.add_hashtags("(linux)") == "(linux)");
+        REQUIRE(matcher.add_hashtags("linux's") == "#linux's");
+    }
+
+    THEN("Watchwords inside words don't match")
+    {
+        REQUIRE(matcher.add_hashtags("gnulinux linuxes") == "gnulinux linuxes");
+        REQUIRE(matcher.add_hashtags("linuxä") == "linuxä");
+    }
+
+    THEN("Watchwords are literal text")
+    {
+        REQUIRE(matcher.add_hashtags("c++ cxx") == "#c++ cxx");
+        REQUIRE(WatchwordMatcher{list<string>{"a.c"}}.add_hashtags("abc a.c")
+                == "abc #a.c");
+    }
+}
+
+SCENARIO("Only the first occurrence of a watchword is tagged")
+{
+    const WatchwordMatcher matcher{list<string>{"rss", "feed"}};
+
+    THEN("Every watchword is tagged once")
+    {
+        REQUIRE(matcher.add_hashtags("rss feed rss feed")
+                == "#rss #feed rss feed");
+    }
+
+    THEN("Occurrences that don't match don't count")
+    {
+        REQUIRE(matcher.add_hashtags("mrss rss") == "mrss #rss");
+    }
+}
+
+SCENARIO("Watchwords are matched case-insensitively")
+{
+    const WatchwordMatcher matcher{
+        list<string>{"Linux", "Äpfel", "σοφία"}};
+
+    THEN("The text keeps its case")
+    {
+        REQUIRE(matcher.add_hashtags("LINUX") == "#LINUX");
+        REQUIRE(matcher.add_hashtags("lInUx") == "#lInUx");
+    }
+
+    THEN("Latin and Greek letters outside of ASCII are folded")
+    {
+        REQUIRE(matcher.add_hashtags("äPFEL") == "#äPFEL");
+        REQUIRE(matcher.add_hashtags("ΣΟΦΊΑ") == "#ΣΟΦΊΑ");
+    }
+}
+
+SCENARIO("Overlapping watchwords")
+{
+    const WatchwordMatcher matcher{
+        list<string>{"open", "open source", "source", "source code"}};
+
+    THEN("The leftmost match wins, then the longest")
+    {
+        REQUIRE(matcher.add_hashtags("open source code")
+                == "#open source code");
+        REQUIRE(matcher.add_hashtags("source code") == "#source code");
+    }
+
+    THEN("Watchwords nested in a hashtag are not tagged")
+    {
+        REQUIRE(matcher.add_hashtags("open source") == "#open source");
+    }
+
+    THEN("Watchwords nested in a hashtag can be tagged later")
+    {
+        REQUIRE(matcher.add_hashtags("open source, source")
+                == "#open source, #source");
+    }
+}
+
+SCENARIO("Saving and loading a WatchwordMatcher")
+{
+    const fs::path path{fs::temp_directory_path()
+                        / fs::unique_path("mastorss-test-%%%%-%%%%.cache")};
+    const WatchwordMatcher::source from{123, 456};
+    bool saved{false};
+
+    {
+        const WatchwordMatcher matcher{list<string>{"linux", "rss"}};
+        saved = matcher.save(path, from);
+    }
+
+    WHEN("The source is the same")
+    {
+        const auto loaded{WatchwordMatcher::load(path, from)};
+
+        THEN("The automaton works like before")
+        {
+            REQUIRE(saved);
+            REQUIRE(loaded.has_value());
+            REQUIRE(loaded->add_hashtags("rss and linux")
+                    == "#rss and #linux");
+        }
+    }
+
+    WHEN("The source changed")
+    {
+        THEN("The file is not loaded")
+        {
+            REQUIRE_FALSE(
+                WatchwordMatcher::load(path, {123, 789}).has_value());
+            REQUIRE_FALSE(
+                WatchwordMatcher::load(path, {124, 456}).has_value());
+        }
+    }
+
+    WHEN("The file doesn't exist")
+    {
+        THEN("Nothing is loaded")
+        {
+            REQUIRE_FALSE(
+                WatchwordMatcher::load(path.string() + ".missing", from)
+                    .has_value());
+        }
+    }
+
+    fs::remove(path);
+}
+
+SCENARIO("A WatchwordMatcher without watchwords")
+{
+    const WatchwordMatcher matcher;
+
+    THEN("It is empty and doesn't change the text")
+    {
+        REQUIRE(matcher.empty());
+        REQUIRE(matcher.add_hashtags("linux") == "linux");
+    }
+}
+
+} // namespace mastorss